@@ -9,13 +9,24 @@
 //#endif
 
 #include <string>
+#include <cstddef>
 
 /* =================================== Public API's =================================== */
 #ifdef __cplusplus    // If used by C++ code,
 
 std::string base64_encode(unsigned char const*, unsigned int len);
+// Decodes up to the first '=' or character outside the alphabet
 std::string base64_decode(std::string const& s);
-//std::string encodeBase64(const std::string& data, size_t size);
-//std::string decodeBase64(const std::string& data, size_t size);
+
+// Exact length of the encoded form of <len> bytes, padding included
+size_t base64_encoded_length(size_t len);
+// Upper bound of the bytes decoded from <len> characters
+size_t base64_decoded_max_length(size_t len);
+// Encode into <out>, which must hold base64_encoded_length(<len>) characters. Returns the count written
+size_t base64_encode_to(unsigned char const* in, size_t len, char* out);
+// Decode like base64_decode into <out>, which must hold base64_decoded_max_length(<len>) bytes. Returns the count written
+size_t base64_decode_to(char const* in, size_t len, unsigned char* out);
+// Kernel picked for this CPU at startup: "avx512vbmi", "avx2", "sse4.1" or "scalar"
+const char* base64_implementation(void);
 
 #endif
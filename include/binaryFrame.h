@@ -0,0 +1,52 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "compression.h"
+
+// Length-prefixed frames of the binary transport, several frames can share one HTTP body.
+// Header (16 bytes, network byte order): u32 payload length | u64 job id | u8 type | u8 flags | u16 reserved
+class BinaryFrame {
+
+public:
+    enum class Type : uint8_t { Heartbeat = 1, Response = 2, Job = 3, Output = 4 };     // Output: partial output of a streamed job
+
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr uint8_t FLAG_CODING_MASK = 0x03;     // Payload coding: 0 identity, 1 deflate, 2 gzip, 3 zstd
+
+    Type type = Type::Response;
+    uint8_t flags = 0;
+    uint64_t jobId = 0;
+    std::string payload;
+
+public:
+    // Append a frame to <out>, the payload is compressed with <coding> when that pays off
+    static void append(std::string &out, Type type, uint64_t jobId, const std::string &payload, Compression::Coding coding);
+    // Split <data> into frames, returns false if it isn't a well-formed frame sequence
+    static bool parse(const std::string &data, std::vector<BinaryFrame> &frames);
+    // Payload with the frame's coding undone
+    bool decodePayload(std::string &decoded) const;
+};
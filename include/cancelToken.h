@@ -0,0 +1,68 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+// Shared between a running job and whoever may stop it (a "cancel" job or the job's deadline).
+// Blocking work polls isStopped(), a child process attached to the token is killed with its group
+class CancelToken {
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::atomic<bool> cancelled {false};
+    const Clock::time_point deadline;
+    std::mutex processMutex;
+    pid_t processGroup = 0;                 // 0 when no child is attached
+
+public:
+    explicit CancelToken(Clock::time_point deadline = Clock::time_point::max());
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+
+    // Mark the job cancelled and kill the attached process group, if any
+    void cancel(void);
+    bool isCancelled(void) const;
+    bool isExpired(void) const;
+    // Cancelled or past the deadline
+    bool isStopped(void) const;
+    // Milliseconds until the deadline, clamped to [0, <cap>]
+    int remainingMs(int cap) const;
+    // Kill the attached process group, e.g. once the deadline has passed
+    void killProcess(void);
+    // The child <pid> leads its own process group, kill it if the job is (or gets) stopped
+    void attachProcess(pid_t pid);
+    // Call before reaping the child, its pid may be reused afterwards
+    void detachProcess(void);
+    // Why the job was stopped, empty if it wasn't
+    std::string stopReason(void) const;
+};
+
+using CancelTokenPtr = std::shared_ptr<CancelToken>;
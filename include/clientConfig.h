@@ -0,0 +1,53 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <chrono>
+
+// Runtime settings, defaults can be overridden from the command line i.e. --name=value
+struct ClientConfig {
+    std::string url;
+    std::string port;
+    std::chrono::milliseconds heartbeatInterval {1000};     // Poll interval when the client has just become idle
+    std::chrono::milliseconds maxIdleInterval {8000};       // Idle polling backs off exponentially up to this interval
+    std::chrono::milliseconds activeInterval {50};          // Poll interval while jobs or responses are in flight
+    std::chrono::seconds longPollWait {0};                  // > 0 enables long-poll, the server may hold a heartbeat this long
+    size_t batchMaxCount {1};                               // > 1 coalesces queued responses into one request
+    size_t batchMaxBytes {1024 * 1024};                     // Byte budget of one batched request (before encoding)
+    size_t workerThreads {0};                               // Threads executing jobs, 0 = number of usable CPUs
+    size_t jobQueueCapacity {64};                           // Jobs waiting for a worker per priority lane, beyond that new jobs are rejected
+    size_t normalWorkers {0};                               // Workers normal and bulk jobs may occupy together, 0 = all but one
+    size_t bulkWorkers {0};                                 // Workers bulk jobs may occupy, 0 = half of them
+    std::chrono::seconds jobTimeout {0};                    // Deadline of jobs without a "timeout" field, 0 = none
+    size_t outputMemoryLimit {1024 * 1024};                 // Command output kept in memory per job, beyond that it spills to a temporary file
+    size_t responseQueueLimit {4 * 1024 * 1024};            // Queued response bytes at which large outputs wait for the sender
+    size_t uploadConcurrency {4};                           // Files a directory upload sends at the same time
+    size_t uploadRateLimit {0};                             // Bytes per second all uploads together may send, 0 = unlimited
+    size_t downloadSegments {1};                            // Parallel range requests of a large download, 1 = a single stream
+};
+
+// Fill <config> from the arguments, returns false (after printing the reason) if they are not valid
+bool parseArguments(int argc, char** argv, ClientConfig &config);
+
+void printUsage(void);
@@ -0,0 +1,44 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+
+// Content codings used for the payloads, availability depends on the libraries found at build time
+class Compression {
+
+public:
+    enum class Coding { Identity, Deflate, Gzip, Zstd };
+
+    static constexpr size_t MIN_COMPRESS_SIZE = 512;     // Smaller payloads (e.g. heartbeats) are sent as they are
+
+public:
+    // Codings this build can decode, in order of preference e.g. "zstd, deflate, gzip"
+    static std::string supportedCodings(void);
+    // Best coding which is both built in and listed in the peer's <acceptedCodings>, Identity if none
+    static Coding negotiate(const std::string &acceptedCodings);
+    static Coding fromName(const std::string &name);
+    static const char* toName(Coding coding);
+    static bool compress(Coding coding, const std::string &input, std::string &output);
+    static bool decompress(Coding coding, const std::string &input, std::string &output);
+};
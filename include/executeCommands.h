@@ -20,9 +20,31 @@
 
 #pragma once
 #include <string>
+#include <vector>
+#include <functional>
+#include <sys/types.h>
+#include "cancelToken.h"
 
 class executeCommand{
 
 public:
-    std::wstring operator()(const std::wstring& shellType, const std::wstring& command, const std::wstring& args);
+    // Receives the output while the child is running, in order and cut at UTF-8 character boundaries
+    using OutputSink = std::function<void(const std::string &chunk)>;
+
+    static constexpr size_t STREAM_CHUNK_SIZE = 16 * 1024;     // Hand output to the sink once this much is pending
+    static constexpr int STREAM_FLUSH_MS = 200;                 // ... or once the oldest pending byte is this old
+
+private:
+    // Start <argv> in its own process group with stdout/stderr on <outputFd>, returns -1 and sets <error> on failure
+    static pid_t spawn(const std::vector<std::string>& argv, int outputFd, int &error);
+    // Block until the child <pid> has exited, killing its process group if <token> gets stopped meanwhile
+    static void waitUntilExited(pid_t pid, CancelToken *token);
+
+public:
+    // The child runs in its own process group, stopping <token> (if given) kills the whole group.
+    // With a <sink> the output is streamed to it instead of being returned, only the exit status is.
+    // Without one, output beyond the memory limit of OutputCapture is returned as a head/tail preview
+    std::string operator()(const std::string& shellType, const std::string& command, const std::string& args, CancelToken *token = nullptr, const OutputSink &sink = nullptr);
+    // Run the program <argv>[0] (looked up in PATH if it has no '/') with the arguments as given, no shell involved
+    std::string operator()(const std::vector<std::string>& argv, CancelToken *token = nullptr, const OutputSink &sink = nullptr);
 };
\ No newline at end of file
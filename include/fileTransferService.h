@@ -21,6 +21,8 @@
 #pragma once
 
 #include <string>
+#include "cancelToken.h"
+#include "partialDownload.h"
 
 
 #if __has_include(<filesystem>)
@@ -37,13 +39,23 @@
 class curlFileTransfer {
 
 private:
-    static bool isDataServerAvailable(const std::string& url);
-    static size_t WriteData(void* buffer, size_t size, size_t nmemb, void* userp);
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    enum class FetchResult { Complete, Retry, Failed };
+    static FetchResult fetchMissingPart(const std::string& url, PartialDownload& part, std::string& errorMsg, CancelToken* token);
+    static FetchResult fetchSegments(const std::string& url, PartialDownload& part, size_t connections, std::string& errorMsg, CancelToken* token);
 
 public:
-    static bool DownloadFileFromURL(const std::wstring& url, const std::wstring& outputDirPath);
-    static bool DownloadDirectoryFromURL(const std::wstring& url, const std::wstring& outputDirPath);
-    static bool UploadFileToURL(const std::wstring& url, const std::wstring& filePath);
-    static bool UploadDirectoryToURL(const std::wstring& url, const std::wstring& dirPath, std::wstring &errorMsg, const std::wstring& extensions);
+    static constexpr size_t MAX_REPORTED_FAILURES = 50;     // Failed files listed by name in a directory upload report
+    static constexpr int MAX_DOWNLOAD_ATTEMPTS = 6;         // Requests a download may take, each resumes where the last stopped
+
+    // Transfers are aborted as soon as <token> (if given) is cancelled or its deadline passes
+    // The file arrives as "<name>.part" and is renamed once complete and, if a SHA-256 is known from <expectedSha256>
+    // or the server's Digest/Repr-Digest header, verified. An interrupted download resumes with a Range request,
+    // also when the job is sent again after the client was restarted. With <segments> above 1 a file of a few MiB
+    // or more is fetched over up to that many connections in parallel byte ranges, if the server supports them
+    static bool DownloadFileFromURL(const std::string& url, const std::string& outputDirPath, const std::string& expectedSha256, size_t segments, std::string& errorMsg, CancelToken *token = nullptr);
+    static bool DownloadDirectoryFromURL(const std::string& url, const std::string& outputDirPath);
+    static bool UploadFileToURL(const std::string& url, const std::string& filePath, CancelToken *token = nullptr);
+    // Uploads TransferEngine::getUploadConcurrency() files at a time. <report> tells how many files were
+    // uploaded and why the others failed, false is returned if any of them failed
+    static bool UploadDirectoryToURL(const std::string& url, const std::string& dirPath, std::string &errorMsg, const std::string& extensions, std::string &report, CancelToken *token = nullptr);
 };
\ No newline at end of file
@@ -23,7 +23,21 @@
 #pragma once
 
 #include <string>
+#include <chrono>
 #include "base64.h"
+#include "compression.h"
+
+class HttpResponseParser;
+
+// How payloads travel in the HTTP body: base64 text (compatible) or raw length-prefixed frames
+enum class TransportMode { Base64, Binary };
+
+// Wire-ready request, header block (terminated by an empty line) and body are sent as separate buffers
+struct HttpRequest {
+    std::string header;
+    std::string body;
+    std::chrono::milliseconds responseTimeout {0};      // How long the server may take to answer, 0 = default
+};
 
 //#define READ_BUFFER_SIZE 1024   // Receiving Buffer Size in bytes
 
@@ -31,17 +45,38 @@ class HttpPost{
 
 using LINUX_SOCKET_FD = int;
 
+enum class ConnectionState { Disconnected, Connected };
+
 private:
-    const unsigned int READ_BUFFER_SIZE = 1024;
-    LINUX_SOCKET_FD tcpSocket;
+    static constexpr unsigned int READ_BUFFER_SIZE = 16 * 1024;
+    static constexpr int FIRST_BYTE_TIMEOUT_MS = 500;        // Server has nothing for us if it doesn't answer within this time
+    static constexpr int READ_TIMEOUT_MS = 5000;             // Maximum gap between two reads of the same response
+    static constexpr int WRITE_TIMEOUT_MS = 5000;            // Maximum time the server may leave a request without taking any of it
+    static constexpr int RESOLVE_TIMEOUT_MS = 2000;          // Name resolution, a stale cached address is used after that
+    static constexpr int CONNECT_TIMEOUT_MS = 5000;          // Establishing the TCP connection, all addresses included
+    static constexpr int ATTEMPT_DELAY_MS = 250;             // Head start of a connection attempt before the next address is tried
+    const std::chrono::seconds IDLE_TIMEOUT {15};          // Kept-alive connection is dropped if it was not used for this long
+    LINUX_SOCKET_FD tcpSocket = -1;
+    ConnectionState state = ConnectionState::Disconnected;
+    std::chrono::steady_clock::time_point lastActivity;
+    std::string connectedUrl;
+    std::string connectedPort;
+    bool serverReachable = false;
+    std::string serverPayloadCodings;                   // Codings the server accepts for request payloads (X-Accept-Payload-Encoding)
+    bool serverAcceptsBinary = false;                   // Server answered with X-Transport: binary
     
 private:
-    int createTcpSocket(void);
-    int connectTcp(const std::wstring &url, const std::wstring &port);
-    int sendHttpRequest(const std::wstring &request);
-    std::wstring recvHttpResponse(void);
+    int createTcpSocket(int family);
+    int connectTcp(const std::string &url, const std::string &port);
+    int sendHttpRequest(const HttpRequest &request);
+    int recvHttpResponse(HttpResponseParser &response, int firstByteTimeoutMs, bool &closedByServer);
+    bool isConnectionReusable(const std::string &url, const std::string &port);
+    void closeConnection(void);
 
 public:
-    std::wstring operator()(const std::wstring &url, const std::wstring &port, const std::wstring &request);    // Call Operator
+    std::string operator()(const std::string &url, const std::string &port, const HttpRequest &request);     // Call Operator, returns the decoded (UTF-8) payload of the reply
+    bool isServerReachable(void) const;                 // Did the last request get through to the server and a 2xx reply back
+    Compression::Coding getPayloadCoding(void) const;   // Coding to use for payloads sent to this server
+    TransportMode getTransportMode(void) const;         // Transport to use for requests sent to this server
     ~HttpPost();
 };
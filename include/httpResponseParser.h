@@ -0,0 +1,69 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// Incremental HTTP/1.x response parser, data is fed as it arrives from the socket
+class HttpResponseParser {
+
+public:
+    enum class Result { NeedMore, Complete, Error };
+
+private:
+    enum class State { StatusLine, Headers, Body, ChunkSize, ChunkData, ChunkDataEnd, Trailers, UntilClose, Complete, Error };
+
+    static constexpr size_t MAX_LINE_LENGTH = 16 * 1024;          // Longest status/header/chunk-size line accepted
+    static constexpr size_t MAX_BODY_RESERVE = 64 * 1024 * 1024;  // Upper bound of the up-front body allocation
+
+    State state = State::StatusLine;
+    std::string line;                                         // Partially received line
+    int statusCode = 0;
+    bool http11 = false;
+    bool chunked = false;
+    bool hasContentLength = false;
+    size_t remaining = 0;                                     // Bytes left of the body or the current chunk
+    std::vector<std::pair<std::string, std::string>> headers; // Header names are lower-cased
+    std::string body;
+
+private:
+    bool parseStatusLine(void);
+    bool parseHeaderLine(void);
+    bool onHeadersComplete(void);
+    bool parseChunkSize(void);
+    bool takeLine(const char *&data, const char *end);
+
+public:
+    void reset(void);
+    // Feed received bytes, <consumed> is set to the number of bytes belonging to this response
+    Result feed(const char *data, size_t len, size_t &consumed);
+    // Notify that the peer closed the connection
+    Result finish(void);
+    bool isComplete(void) const;
+    bool isKeepAlive(void) const;
+    int getStatusCode(void) const;
+    std::string getHeader(const std::string &name) const;
+    const std::string& getBody(void) const;
+};
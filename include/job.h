@@ -0,0 +1,75 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A job sent by the server, decoded in a single in-situ pass.
+// The text fields are UTF-8 views into the job's own buffer, absent fields are empty
+class Job {
+
+private:
+    std::string buffer;                     // The JSON, strings are unescaped in place
+
+public:
+    uint64_t id = 0;                        // "jobId", 0 if the server didn't give one
+    uint64_t cancelJobId = 0;               // Target of a "cancel" job
+    uint64_t timeoutSecs = 0;               // "timeout", 0 if the job has no deadline of its own
+    uint64_t segments = 0;                  // "segments", connections a download may use, 0 for the client's default
+    std::string_view modeName;              // "mode", resolved to a handler by findJobHandler()
+    std::string_view priority;
+    std::string_view url;
+    std::string_view port;
+    std::string_view filePath;
+    std::string_view destPath;
+    std::string_view dirPath;
+    std::string_view fileExtensions;
+    std::string_view shellType;
+    std::string_view exePath;
+    std::string_view exeArguments;
+    std::string_view dirToList;
+    std::string_view sourcePath;
+    std::string_view path;
+    std::string_view command;
+    std::string_view cd;
+    std::string_view session;               // Shell session of a "shell" job, "default" if empty
+    std::string_view method;
+    std::string_view stream;                // "true" streams the output of shell/execute jobs while they run
+    std::string_view sha256;                // Expected SHA-256 (hex) of a downloaded file, optional
+    std::vector<std::string_view> argv;     // "argv": ["arg1", ...], arguments passed as is, without a shell
+    bool argvValid = true;                  // false if "argv" held anything but strings, <argv> is incomplete then
+
+public:
+    Job() = default;
+    Job(const Job&) = delete;               // The views point into <buffer>, it must never move
+    Job& operator=(const Job&) = delete;
+
+    // Decode the reply <json>, returns nullptr if it isn't a JSON object
+    static std::shared_ptr<const Job> parse(std::string json);
+};
+
+using JobPtr = std::shared_ptr<const Job>;
@@ -23,20 +23,22 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <string_view>
+#include <utility>
 
+// All strings are UTF-8
 class JsonUtil {
 
-private:
-    static std::string wstring_to_utf8(const std::wstring& wideStr);
-    static std::wstring utf8_to_wstring(const std::string& str);
-
 public:
     // data -----> json
-    static std::wstring to_json(const std::vector<std::wstring>& data);
+    static std::string to_json(const std::vector<std::string>& data);
     // json -----> data
-    static std::vector<std::wstring> from_json(const std::wstring& jsonData);
+    static std::vector<std::string> from_json(const std::string& jsonData);
     // Extract <value> from json using <key>
-    static std::wstring json_ExtractValue(const std::wstring& jsonData, const std::wstring& key);
+    static std::string json_ExtractValue(const std::string& jsonData, const std::string& key);
     // Insert a key-value pair into an existing JSON string
-    static std::wstring json_AppendKeyValue(const std::wstring& jsonData, const std::wstring& key, const std::wstring& value);
+    static std::string json_AppendKeyValue(const std::string& jsonData, const std::string& key, const std::string& value);
+    // Insert string members into the JSON object <jsonData>, in one pass without parsing it
+    static std::string json_AppendKeyValues(const std::string& jsonData, const std::vector<std::pair<std::string_view, std::string_view>>& members);
 };
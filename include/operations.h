@@ -23,6 +23,11 @@
 #pragma once
 #include <string>
 #include "sharedResourceManager.h"
+#include "priority.h"
+#include "cancelToken.h"
+#include "job.h"
+#include <chrono>
+#include <cstdint>
 
 #if __has_include(<filesystem>)
     #include <filesystem>
@@ -35,5 +40,31 @@
 #endif
 
 
-bool isJobAvailable(const std::wstring &replyFromServe);
-void startJob(SharedResourceManager &sharedResources);
+struct JobReply {
+    std::string type {"log"};           // Key of the reply i.e. "log", "shellResponse"
+    std::string data;
+    uint32_t sequence = 0;              // Streamed jobs: "seq" of the final reply, after the partial ones
+};
+
+// Registered once per mode, see jobHandlers in operations.cpp
+struct JobHandler {
+    std::string_view mode;
+    Priority priority;                  // Lane of the job, unless the job asks for another one
+    bool runsInline;                    // Run on the polling thread, not queued behind other jobs (i.e. cancel)
+    void (*run)(const Job &job, SharedResourceManager &sharedResources, CancelToken &token, JobReply &reply);
+};
+
+// Handler of <mode>, nullptr if the mode isn't supported
+const JobHandler* findJobHandler(std::string_view mode);
+bool isJobAvailable(const Job &job);
+// Lane of <job>, from its "priority" field ("interactive", "normal", "bulk") or else from its mode
+Priority jobPriority(const Job &job);
+// Longest "timeout" a job may ask for, a job asking for more is rejected. Keeps the deadline far from overflowing the clock
+constexpr uint64_t MAX_JOB_TIMEOUT_SECS = 7 * 24 * 60 * 60;
+// Token for <job>, its deadline is the job's "timeout" (secs) or else <defaultTimeout>, 0 = none.
+// Both are clamped to MAX_JOB_TIMEOUT_SECS
+CancelTokenPtr createCancelToken(const Job &job, std::chrono::seconds defaultTimeout);
+// Run the handler of <job> and queue its reply
+void startJob(const Job &job, SharedResourceManager &sharedResources, CancelToken &token);
+// Answer <job> with <reason> instead of running it
+void rejectJob(const Job &job, const std::string &reason, SharedResourceManager &sharedResources);
@@ -0,0 +1,70 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Output of a command that isn't streamed. Up to a memory limit it is kept in memory, beyond that everything
+// goes to an unlinked temporary file, so a command printing gigabytes can't exhaust the memory of the client.
+// The first and the last bytes are always kept in memory as well, for a preview of spilled output
+class OutputCapture {
+
+private:
+    size_t memoryLimit;
+    size_t previewSize;
+    std::string memory;                     // The whole output while it fits
+    std::string head;                       // First <previewSize> bytes
+    std::string tailRing;                   // Last <previewSize> bytes, oldest at <tailStart> once full
+    size_t tailStart = 0;
+    size_t total = 0;                       // Bytes appended
+    size_t stored = 0;                      // Bytes in <memory> or the file, less than <total> if writing the file failed
+    int spillFd = -1;
+    bool spillFailed = false;               // The file couldn't be created or written, later output only updates the previews
+
+private:
+    bool spill(void);
+    size_t writeToFile(const char *data, size_t length);
+
+public:
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 1024 * 1024;
+    static constexpr size_t DEFAULT_PREVIEW_SIZE = 4 * 1024;
+
+    explicit OutputCapture(size_t memoryLimit = DEFAULT_MEMORY_LIMIT, size_t previewSize = DEFAULT_PREVIEW_SIZE);
+    ~OutputCapture();
+    OutputCapture(const OutputCapture&) = delete;
+    OutputCapture& operator=(const OutputCapture&) = delete;
+
+    void append(const char *data, size_t length);
+    void append(const std::string &data);
+    size_t size(void) const;
+    // Bytes that can be read back, less than size() if the temporary file couldn't take everything
+    size_t storedSize(void) const;
+    bool isSpilled(void) const;
+    // The whole output, only valid while it isn't spilled
+    const std::string& text(void) const;
+    std::string getHead(void) const;
+    std::string getTail(void) const;
+    // Head and tail joined by a line telling how much is left out, both cut at UTF-8 character boundaries
+    std::string getPreview(void) const;
+    // Copy up to <length> bytes from <offset> of the stored output into <buffer>, returns the count copied
+    size_t read(size_t offset, char *buffer, size_t length) const;
+};
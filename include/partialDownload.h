@@ -0,0 +1,90 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+// Headers of a download response that decide whether it continues the data already on disk
+struct DownloadHeaders {
+    std::string etag;
+    std::string lastModified;
+    std::string sha256;                                 // From Digest (RFC 3230) or Repr-Digest (RFC 9530), lower case hex
+    int64_t contentLength = -1;
+    int64_t rangeStart = -1;                            // Content-Range of a 206 reply, -1 if absent
+    int64_t rangeTotal = -1;
+    bool acceptsRanges = false;                         // "Accept-Ranges: bytes"
+    int64_t retryAfter = -1;                            // Seconds to wait from Retry-After, -1 if absent
+
+    // Take one raw header line as curl hands it over, a status line starts a new response
+    void parse(const std::string &rawLine);
+    // ETag, or Last-Modified if the server sent no ETag
+    std::string validator(void) const;
+};
+
+// A download in progress. The data goes to "<path>.part" and "<path>.part.state" records where it came from,
+// so a later attempt, even after the client was restarted, continues where the last one stopped. The file
+// only appears under <path> once it is complete
+class PartialDownload {
+
+private:
+    std::string finalPath;
+    std::string partPath;
+    std::string statePath;
+    int fd = -1;
+
+public:
+    std::string url;
+    std::string validator;                              // ETag (or Last-Modified) of the file on the server
+    int64_t totalSize = -1;                             // -1 while unknown
+    std::string sha256;                                 // Digest the server announced, lower case hex
+    std::vector<std::pair<int64_t, int64_t>> pendingRanges;     // [start, end) still missing of a segmented download
+    int64_t syncedSize = 0;                             // Bytes of a single stream download known to be on disk
+
+public:
+    explicit PartialDownload(const std::string &finalPath);
+    ~PartialDownload();
+    PartialDownload(const PartialDownload&) = delete;
+    PartialDownload& operator=(const PartialDownload&) = delete;
+
+    // Open the part file for <url>. Data left by an earlier attempt is kept if its state record names the same <url>,
+    // <resumeOffset> is set to the number of bytes present. Anything a single stream download wrote past <syncedSize>
+    // may not have survived a crash intact and is cut off
+    bool open(const std::string &url, int64_t &resumeOffset);
+    // Forget the data so far, e.g. because the file changed on the server
+    bool restart(void);
+    // A segmented download preallocates the file, its progress is kept in <pendingRanges>
+    bool isSegmented(void) const;
+    // Reserve <size> bytes on disk up front, fails early if the file system is full
+    bool preallocate(int64_t size);
+    bool saveState(void);
+    bool write(int64_t offset, const char *data, size_t len);
+    int64_t size(void) const;
+    // Lower case hex SHA-256 of the data so far
+    std::string computeSha256(void) const;
+    // Flush the part file to disk and rename it to its final path
+    bool finalize(void);
+    // Remove the part file and the state record
+    void discard(void);
+};
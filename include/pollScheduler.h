@@ -0,0 +1,59 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <chrono>
+
+// Decides when the next heartbeat/poll goes out. Sleeps on a timerfd and can be woken
+// early (e.g. when a response gets queued) through an eventfd, both watched by one epoll
+class PollScheduler {
+
+using LINUX_FD = int;
+
+private:
+    LINUX_FD epollFd = -1;
+    LINUX_FD timerFd = -1;
+    LINUX_FD wakeFd = -1;
+    const std::chrono::milliseconds heartbeatInterval;
+    const std::chrono::milliseconds maxIdleInterval;
+    const std::chrono::milliseconds activeInterval;
+    std::chrono::milliseconds nextInterval;
+
+private:
+    void armTimer(std::chrono::milliseconds interval);
+
+public:
+    PollScheduler(std::chrono::milliseconds heartbeat, std::chrono::milliseconds maxIdle, std::chrono::milliseconds active);
+    ~PollScheduler();
+    PollScheduler(const PollScheduler&) = delete;
+    PollScheduler& operator=(const PollScheduler&) = delete;
+
+    // Something happened (job received, response sent, jobs running): poll again soon
+    void onActivity(void);
+    // Poll came back empty or server unreachable: back off exponentially
+    void onIdle(void);
+    // Thread-safe, cuts the current wait short
+    void wake(void);
+    // Block until the next poll is due, wake() is called or a signal interrupts the wait
+    void waitForNextPoll(void);
+};
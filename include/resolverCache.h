@@ -0,0 +1,69 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <sys/socket.h>
+
+struct ResolvedAddress {
+    struct sockaddr_storage address;
+    socklen_t length;
+    int family;
+};
+
+// Process-wide cache of getaddrinfo() results. getaddrinfo() doesn't report the record TTL so entries
+// live for a fixed time; a stale entry is still used when a refresh fails or takes too long
+class ResolverCache {
+
+private:
+    struct Entry {
+        std::vector<ResolvedAddress> addresses;
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+    struct PendingLookup;
+    // Shared with the lookup threads, which may still run when the statics are destroyed at exit
+    struct State {
+        std::mutex mutex;
+        std::map<std::string, Entry> cache;
+        std::map<std::string, std::shared_ptr<PendingLookup>> pendingLookups;
+    };
+
+    static std::shared_ptr<State> state;
+
+private:
+    static std::vector<ResolvedAddress> lookup(const std::string &host, const std::string &port);
+
+public:
+    static constexpr std::chrono::seconds TTL {60};
+
+    // Addresses of <host>:<port> ordered for connection racing (families interleaved, RFC 8305),
+    // waits at most <timeout> for the resolver
+    static bool resolve(const std::string &host, const std::string &port, std::chrono::milliseconds timeout, std::vector<ResolvedAddress> &addresses);
+    // Forget <host>:<port> e.g. after none of its addresses could be reached
+    static void invalidate(const std::string &host, const std::string &port);
+};
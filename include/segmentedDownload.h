@@ -0,0 +1,83 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include "curl/curl.h"
+#include "cancelToken.h"
+#include "partialDownload.h"
+
+// Fetches the pending byte ranges of a preallocated PartialDownload over several connections at once, each
+// response is written at its offset. When a connection runs out of work it takes over half of the largest
+// range still being fetched, so all of them stay busy until the end instead of leaving one slow tail
+class SegmentedDownload {
+
+public:
+    enum class Result {
+        Complete,
+        Retry,                                          // Network trouble or the file changed, <part> says where to go on
+        Failed,
+        RangesUnsupported                               // The server answered a range request with the whole file
+    };
+
+private:
+    struct Segment {
+        int64_t next;                                   // First byte still missing
+        int64_t end;                                    // One past the last byte of the segment
+        std::chrono::steady_clock::time_point notBefore {};     // A failed range backs off until then
+    };
+    struct Transfer;
+
+    std::string url;
+    PartialDownload &part;
+    size_t connections;                                 // Transfers allowed at once, lowered when the server pushes back
+    CancelToken *token;
+    CURLM *multi;
+    std::vector<Segment> idle;                          // Missing ranges no transfer is working on
+    std::vector<std::unique_ptr<Transfer>> transfers;
+    std::chrono::steady_clock::time_point savedAt;
+
+private:
+    static size_t writeSegment(void *buffer, size_t size, size_t nmemb, void *userp);
+    static size_t readHeader(char *buffer, size_t size, size_t nitems, void *userp);
+    bool takeWork(Segment &segment);
+    bool start(const Segment &segment);
+    void saveProgress(void);
+    void stopTransfers(void);
+
+public:
+    static constexpr int64_t MIN_SEGMENT_SIZE = 1024 * 1024;   // Smaller ranges aren't worth another request
+    static constexpr size_t MAX_CONNECTIONS = 16;
+    static constexpr int MAX_FAILURES = 8;                     // Failed ranges in a row before the attempt gives up
+    static constexpr int64_t MAX_RETRY_AFTER_SECS = 120;        // Longer Retry-After waits are cut to this
+
+    SegmentedDownload(const std::string &url, PartialDownload &part, size_t connections, CancelToken *token = nullptr);
+    ~SegmentedDownload();
+    SegmentedDownload(const SegmentedDownload&) = delete;
+    SegmentedDownload& operator=(const SegmentedDownload&) = delete;
+
+    Result run(std::string &errorMsg);
+};
@@ -0,0 +1,45 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Incremental SHA-256 (FIPS 180-4), used to check downloads against the digest the server announced
+class Sha256 {
+
+private:
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t blockSize = 0;                               // Bytes waiting in <block>
+    uint64_t totalSize = 0;
+
+private:
+    void transform(const uint8_t *data);
+
+public:
+    Sha256();
+    void update(const void *data, size_t len);
+    // Lower case hex of the digest, the object can't be updated afterwards
+    std::string hexDigest(void);
+};
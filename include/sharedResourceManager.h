@@ -21,24 +21,60 @@
 
 #pragma once
 #include <queue>
+#include <vector>
 #include <mutex>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <array>
+#include <map>
+#include <condition_variable>
+#include "priority.h"
+#include "cancelToken.h"
+#include "shellSession.h"
+
+struct JobResponse {
+	uint64_t jobId = 0;			// Job this response belongs to, 0 if the server didn't give one
+	std::string json;			// UTF-8 encoded JSON
+	Priority priority = Priority::Normal;	// Lane of the job, decides the sending order
+	bool partial = false;			// Streamed output, more responses of the job follow
+};
 
 class SharedResourceManager {
 
 private:
-	std::queue<std::wstring> responseQueue;
+	std::array<std::queue<JobResponse>, PRIORITY_LANES> responseQueues;		// Drained highest priority first
 	std::mutex responseQueueMutex;
-	std::queue<std::wstring> jobQueue;
-	std::mutex jobQueueMutex;
-	std::wstring jsonSysInfo;
+	size_t queuedBytes = 0;					// JSON bytes waiting in <responseQueues>
+	size_t responseQueueLimit = 4 * 1024 * 1024;		// Producers of bulk output wait while <queuedBytes> is above
+	std::condition_variable responseQueueDrained;
+	size_t outputMemoryLimit = 1024 * 1024;			// Command output kept in memory per job, the rest spills to disk
+	std::string jsonSysInfo;
 	std::mutex jsonSysInfoMutex;
+	std::function<void()> responseListener;			// Invoked after a response is queued, guarded by responseQueueMutex
+	std::map<uint64_t, CancelTokenPtr> activeJobs;		// Queued or running jobs by id, so they can be cancelled
+	std::mutex activeJobsMutex;
+	ShellSessions shellSessions;
 
 public:
-	void pushResponse(const std::wstring &response);
-	std::wstring popResponse(void);
-	void pushJob(const std::wstring &job);
-	std::wstring popJob(void);
+	void pushResponse(JobResponse response);
+	// Pop queued responses, highest priority first, until <maxCount> or <maxBytes> is reached, the first one is always taken
+	std::vector<JobResponse> popResponses(size_t maxCount, size_t maxBytes);
 	bool isResponseAvailable(void);
-	void setSysInfoInJson(const std::wstring &sysInfoJson);
-	std::wstring getSysInfoInJson(void);
+	// Block until the queued responses are below the byte limit, returns false if <token> got stopped meanwhile
+	bool waitForResponseSpace(const CancelToken &token);
+	void setResponseQueueLimit(size_t bytes);
+	void setOutputMemoryLimit(size_t bytes);
+	size_t getOutputMemoryLimit(void);
+	void setSysInfoInJson(const std::string &sysInfoJson);
+	std::string getSysInfoInJson(void);
+	void setResponseListener(std::function<void()> listener);
+	// Returns false if a job with <jobId> is already active
+	bool registerJob(uint64_t jobId, CancelTokenPtr token);
+	void unregisterJob(uint64_t jobId);
+	// Token of the active job <jobId>, nullptr if there is none
+	CancelTokenPtr findJob(uint64_t jobId);
+	// Stop every queued and running job, i.e. on shutdown
+	void cancelAllJobs(void);
+	ShellSessions& getShellSessions(void);
 };
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <sys/types.h>
+#include "cancelToken.h"
+#include "executeCommands.h"
+
+// A long-lived shell whose output goes to a PTY. Commands run one after the other in the same
+// shell, so the working directory, variables and functions carry over from one command to the next
+class ShellSession {
+
+private:
+    pid_t shellPid = -1;                    // Leads its own session and process group
+    int ptyMaster = -1;                     // Output of the shell and its commands
+    int commandPipe = -1;                   // Commands are written here, the shell reads them from stdin
+    std::string marker;                     // Printed after every command, followed by its exit status
+    std::mutex commandMutex;                // One command at a time
+    std::atomic<std::chrono::steady_clock::rep> lastUsed {0};
+    std::atomic<bool> alive {false};
+
+private:
+    void terminate(void);
+
+public:
+    static constexpr int START_TIMEOUT_MS = 5000;   // For the shell to run its first command
+
+    ShellSession() = default;
+    ~ShellSession();
+    ShellSession(const ShellSession&) = delete;
+    ShellSession& operator=(const ShellSession&) = delete;
+
+    // <text> single quoted for the shell
+    static std::string quote(const std::string &text);
+    // Start <shell> in <workingDir>, returns false and sets <error> on failure
+    bool start(const std::string &shell, const std::string &workingDir, std::string &error);
+    // Run <command> in the session and wait for it. Output is returned, or streamed to <sink> if given.
+    // Stopping <token> ends the whole session, the next command gets a fresh one
+    std::string run(const std::string &command, CancelToken *token, const executeCommand::OutputSink &sink, int &exitStatus);
+    bool isAlive(void) const;
+    std::chrono::steady_clock::time_point getLastUsed(void) const;
+};
+
+// Sessions by id, created on first use
+class ShellSessions {
+
+private:
+    std::map<std::string, std::shared_ptr<ShellSession>> sessions;
+    std::mutex sessionsMutex;
+
+public:
+    static constexpr size_t MAX_SESSIONS = 8;   // Beyond that the least recently used session no job holds is closed
+
+    // Session <id>, a new one is started if there is none or it has ended. nullptr and <error> set on failure
+    std::shared_ptr<ShellSession> acquire(const std::string &id, std::string &error);
+    void closeAll(void);
+};
@@ -23,15 +23,16 @@
 
 #include <string>
 #include <vector>
+#include <string_view>
 
 class StringUtils {
 
 public:
-	static std::wstring s2ws(const std::string& str);
-	static std::string ws2s(const std::wstring& wstr);
-	static std::string convertWStringToUTF8(const std::wstring& wstr);
 	static std::vector<std::string> extract_items_from_str(const std::string& input_str, const std::string& delimiter);
-	static std::string wstring_to_utf8(const std::wstring& wideStr);
-	static std::wstring utf8_to_wstring(const std::string& str);
-	static std::wstring extractFilename(const std::wstring& filePath);
+	static std::string extractFilename(const std::string& filePath);
+	// Length of <str> without a trailing, not yet complete UTF-8 sequence
+	static size_t utf8CompleteLength(const std::string& str);
+	static bool isValidUtf8(std::string_view str);
+	// <str> with every byte that isn't part of a valid UTF-8 sequence replaced by '?', i.e. binary command output
+	static std::string toValidUtf8(std::string_view str);
 };
\ No newline at end of file
@@ -31,10 +31,9 @@ private:
 
 private:
 	static std::string generateRandomAlphanumeric(const int &length, const long long &seed);
-	static std::wstring s2ws(const std::string& str);
 
 public:
-	static std::wstring getComputerName();
-	static std::wstring getUserName();
-	static std::vector<std::wstring> getSysInfo();
+	static std::string getComputerName();
+	static std::string getUserName();
+	static std::vector<std::string> getSysInfo();
 };
\ No newline at end of file
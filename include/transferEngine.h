@@ -0,0 +1,111 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include "curl/curl.h"
+
+// Token bucket, hands out <bytesPerSecond> on average with bursts of a tenth of a second
+class RateLimiter {
+
+private:
+    std::mutex mutex;
+    size_t rate = 0;                                    // Bytes per second, 0 = unlimited
+    double tokens = 0;
+    std::chrono::steady_clock::time_point refilledAt;
+
+private:
+    size_t capacity(void) const;
+    void refill(void);
+
+public:
+    static constexpr size_t MIN_GRANT = 16 * 1024;      // Smaller grants would only produce tiny writes
+
+    void setRate(size_t bytesPerSecond);
+    bool isLimited(void);
+    // Number of bytes (up to <wanted>) which may be sent now, 0 if the bucket holds less than MIN_GRANT
+    size_t take(size_t wanted);
+    // Return bytes which were granted but not sent
+    void giveBack(size_t bytes);
+    // Time until take() can grant something again
+    std::chrono::milliseconds waitTime(void);
+};
+
+// Process-wide libcurl state for the file transfers. All easy handles share one DNS cache, connection
+// cache and TLS session cache, and idle handles are kept for reuse, so consecutive transfers to the
+// same server skip name resolution, the TCP/TLS handshakes and the handle setup
+class TransferEngine {
+
+private:
+    static std::mutex poolMutex;
+    static std::vector<CURL*> idleHandles;
+    static CURLSH* share;
+    static std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+    static bool initialized;
+    static size_t uploadConcurrency;
+    static RateLimiter uploadLimiter;
+    static size_t downloadSegments;
+
+private:
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void*);
+    static void unlockShare(CURL*, curl_lock_data data, void*);
+    static void applyDefaults(CURL* curl);
+
+public:
+    static constexpr size_t MAX_IDLE_HANDLES = 8;
+
+    // Call once from main before any other thread is started (curl_global_init isn't thread-safe)
+    static bool init(void);
+    // Call once after every transfer finished, i.e. after the worker pool was shut down
+    static void cleanup(void);
+    // An easy handle with the default options, attached to the share. nullptr if curl is out of memory
+    static CURL* acquire(void);
+    // Hand <curl> back to the pool, its options are reset but its connections stay cached
+    static void release(CURL* curl);
+
+    // Files a directory upload sends at the same time
+    static void setUploadConcurrency(size_t transfers);
+    static size_t getUploadConcurrency(void);
+    // Shared by all uploads, so the cap holds however many run at once
+    static RateLimiter& getUploadLimiter(void);
+    // Connections a large download is split over unless its job asks for another number
+    static void setDownloadSegments(size_t connections);
+    static size_t getDownloadSegments(void);
+};
+
+// Borrows a handle from the TransferEngine for the lifetime of the object
+class TransferHandle {
+
+private:
+    CURL* curl;
+
+public:
+    TransferHandle() : curl(TransferEngine::acquire()) {}
+    ~TransferHandle() { TransferEngine::release(curl); }
+    TransferHandle(const TransferHandle&) = delete;
+    TransferHandle& operator=(const TransferHandle&) = delete;
+
+    CURL* get(void) const { return curl; }
+    explicit operator bool(void) const { return curl != nullptr; }
+};
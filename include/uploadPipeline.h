@@ -0,0 +1,84 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "curl/curl.h"
+#include "cancelToken.h"
+
+struct UploadResult {
+    std::string filePath;
+    CURLcode code = CURLE_OK;
+    long httpStatus = 0;
+    std::string error;                                  // Why the upload failed, empty on success
+
+    bool succeeded(void) const { return error.empty(); }
+};
+
+// Uploads files to one URL as multipart field "file", several at a time on a curl multi handle (multiplexed
+// over HTTP/2 when the server offers it). A producer thread push()es files into a bounded queue while run()
+// uploads them, so the first transfers start long before the producer is done
+class UploadPipeline {
+
+private:
+    struct Transfer;
+
+    std::string url;
+    size_t concurrency;
+    CancelToken *token;
+    CURLM *multi;
+    std::vector<std::unique_ptr<Transfer>> transfers;   // In flight on <multi>
+    std::deque<std::string> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueSpace;
+    bool closed = false;                                // No more files will be pushed
+    bool stopped = false;                               // run() gave up, files are refused
+
+private:
+    static size_t readFileChunk(char *buffer, size_t size, size_t nitems, void *arg);
+    static int seekFile(void *arg, curl_off_t offset, int origin);
+    std::unique_ptr<Transfer> start(const std::string &filePath, UploadResult &result);
+    UploadResult finish(Transfer &transfer, CURLcode code);
+    void resumePaused(void);
+    void stop(void);
+
+public:
+    static constexpr size_t QUEUE_CAPACITY = 64;
+
+    UploadPipeline(const std::string &url, size_t concurrency, CancelToken *token = nullptr);
+    ~UploadPipeline();
+    UploadPipeline(const UploadPipeline&) = delete;
+    UploadPipeline& operator=(const UploadPipeline&) = delete;
+
+    // Producer side, blocks while the queue is full. Returns false once run() stopped taking files
+    bool push(std::string filePath);
+    // Producer side, no more files follow
+    void close(void);
+    // Upload until the queue is closed and drained, <onResult> returns false or the token is stopped
+    void run(const std::function<bool(const UploadResult&)> &onResult);
+};
@@ -22,7 +22,9 @@
 
 #pragma once
 
-#include "utilities.h"
+#include "http.h"
+#include "compression.h"
+#include "sharedResourceManager.h"
 #include <string>
 #include <vector>
 
@@ -36,23 +38,23 @@
     #error "Neither <filesystem> nor <experimental/filesystem> are available."
 #endif
 
-std::wstring createHeartbeatRequest(const std::wstring &sysInfoInJson);
+HttpRequest createHeartbeatRequest(const std::string &sysInfoInJson, std::chrono::seconds longPollWait = std::chrono::seconds(0), TransportMode transport = TransportMode::Base64);
 
-bool isValidPort(const std::string& portNum);
+HttpRequest createDataRequest(const std::vector<JobResponse> &responses, Compression::Coding coding, TransportMode transport);
 
-bool hasWritePermissionForDirectory(const std::wstring &dirPath);
+bool isValidPort(const std::string& portNum);
 
-std::wstring changeDir(const std::wstring& newPath, std::error_code& ec);
+bool hasWritePermissionForDirectory(const std::string &dirPath);
 
-std::wstring ExtractLastDirectoryName(const std::wstring& path);
+std::string ExtractLastDirectoryName(const std::string& path);
 
-bool isExecutable(const std::wstring& path);
+bool isExecutable(const std::string& path);
 
 std::size_t calculateDirectorySize(const std::string& path);
 
-std::string extractBase64Data(const std::wstring &buff);
+std::string extractBase64Data(const std::string &buff);
 
-std::wstring ReplaceTildeWithPath(const std::wstring& filePath);
+std::string ReplaceTildeWithPath(const std::string& filePath);
 
 bool isDataServerAvailable(const std::string& url);
 
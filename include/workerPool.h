@@ -0,0 +1,75 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <array>
+#include "priority.h"
+
+// Fixed set of threads executing jobs from bounded per-priority queues.
+// laneLimits[p] caps the running tasks of lane p and all lanes below it, so with the
+// defaults an interactive job always finds a worker that bulk and normal jobs can't take
+class WorkerPool {
+
+public:
+    using Task = std::function<void()>;
+
+private:
+    std::vector<std::thread> workers;
+    std::array<std::deque<Task>, PRIORITY_LANES> tasks;
+    std::array<size_t, PRIORITY_LANES> runningTasks {};
+    std::array<size_t, PRIORITY_LANES> laneLimits {};
+    std::mutex tasksMutex;
+    std::condition_variable tasksAvailable;
+    const size_t queueCapacity;
+    bool stopping = false;
+
+private:
+    void workerLoop(void);
+    // Highest priority lane with a queued task that may start now, PRIORITY_LANES if none
+    size_t nextRunnableLane(void) const;
+
+public:
+    // A limit of 0 picks the default: all workers (interactive), one less (normal), half of them (bulk)
+    WorkerPool(size_t threadCount, size_t queueCapacity, std::array<size_t, PRIORITY_LANES> laneLimits = {});
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queue <task> in the lane of <priority>, returns false without queueing it if that queue is full or the pool is stopping
+    bool trySubmit(Priority priority, Task task);
+    // No lane has room for another task, callers should stop fetching work
+    bool isFull(void);
+    // Tasks are queued or running
+    bool isBusy(void);
+    // Drop the tasks which haven't started yet, let the running ones finish and join the threads
+    void shutdown(void);
+
+    // CPUs this process may use, honouring the affinity mask and the cgroup CPU quota
+    static size_t availableCpuCount(void);
+};
@@ -1,164 +1,344 @@
-
 #include "base64.h"
-#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+// The vector kernels need GCC/Clang target attributes and are picked at runtime, so the binary still runs on any x86 CPU
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BASE64_X86_KERNELS
+#include <immintrin.h>
+#endif
 
-static const std::string base64_chars =
+static constexpr char base64_chars[] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 "abcdefghijklmnopqrstuvwxyz"
 "0123456789+/";
 
+static const uint8_t INVALID = 0xFF;
+
+// Character -> 6 bit value, INVALID for '=' and everything outside the alphabet
+struct DecodeTable {
+	uint8_t values[256];
+	constexpr DecodeTable() : values() {
+		for (int i = 0; i < 256; ++i) {
+			values[i] = INVALID;
+		}
+		for (int i = 0; i < 64; ++i) {
+			values[static_cast<uint8_t>(base64_chars[i])] = static_cast<uint8_t>(i);
+		}
+	}
+};
+static constexpr DecodeTable decodeTable;
+
+// Block kernels handle a prefix of the input in whole vector blocks and return how much of it they consumed,
+// the scalar code finishes the rest. Decoders also stop at the first block with a character outside the alphabet
+using EncodeBlocks = size_t (*)(const uint8_t *in, size_t len, char *out);
+using DecodeBlocks = size_t (*)(const char *in, size_t len, uint8_t *out);
 
-static inline bool is_base64(unsigned char c) {
-	return (isalnum(c) || (c == '+') || (c == '/'));
+static size_t encodeScalar(const uint8_t *in, size_t len, char *out) {
+	char *start = out;
+	size_t i = 0;
+	for (; i + 3 <= len; i += 3) {
+		const uint32_t triple = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+		*out++ = base64_chars[(triple >> 18) & 0x3F];
+		*out++ = base64_chars[(triple >> 12) & 0x3F];
+		*out++ = base64_chars[(triple >> 6) & 0x3F];
+		*out++ = base64_chars[triple & 0x3F];
+	}
+	if (i < len) {
+		const uint32_t triple = (uint32_t(in[i]) << 16) | ((i + 1 < len) ? (uint32_t(in[i + 1]) << 8) : 0);
+		*out++ = base64_chars[(triple >> 18) & 0x3F];
+		*out++ = base64_chars[(triple >> 12) & 0x3F];
+		*out++ = (i + 1 < len) ? base64_chars[(triple >> 6) & 0x3F] : '=';
+		*out++ = '=';
+	}
+	return static_cast<size_t>(out - start);
 }
 
-std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
-	std::string ret;
-	int i = 0;
-	int j = 0;
-	unsigned char char_array_3[3];
-	unsigned char char_array_4[4];
-
-	while (in_len--) {
-		char_array_3[i++] = *(bytes_to_encode++);
-		if (i == 3) {
-			char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-			char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-			char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-			char_array_4[3] = char_array_3[2] & 0x3f;
-
-			for (i = 0; (i <4); i++)
-				ret += base64_chars[char_array_4[i]];
-			i = 0;
+static size_t decodeScalar(const char *in, size_t len, uint8_t *out) {
+	uint8_t *start = out;
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		const uint8_t a = decodeTable.values[static_cast<uint8_t>(in[i])];
+		const uint8_t b = decodeTable.values[static_cast<uint8_t>(in[i + 1])];
+		const uint8_t c = decodeTable.values[static_cast<uint8_t>(in[i + 2])];
+		const uint8_t d = decodeTable.values[static_cast<uint8_t>(in[i + 3])];
+		if ((a | b | c | d) > 63) {
+			break;                      // Padding or garbage, the partial quad below deals with it
+		}
+		const uint32_t quad = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+		*out++ = static_cast<uint8_t>(quad >> 16);
+		*out++ = static_cast<uint8_t>(quad >> 8);
+		*out++ = static_cast<uint8_t>(quad);
+	}
+	// Up to three characters before the end, the padding or the first invalid character
+	uint32_t quad = 0;
+	size_t count = 0;
+	for (; i < len && count < 4; ++i, ++count) {
+		const uint8_t value = decodeTable.values[static_cast<uint8_t>(in[i])];
+		if (value == INVALID) {
+			break;
 		}
+		quad |= uint32_t(value) << (18 - 6 * count);
 	}
+	if (count >= 2) { *out++ = static_cast<uint8_t>(quad >> 16); }
+	if (count >= 3) { *out++ = static_cast<uint8_t>(quad >> 8); }
+	return static_cast<size_t>(out - start);
+}
 
-	if (i)
-	{
-		for (j = i; j < 3; j++)
-			char_array_3[j] = '\0';
+#ifdef BASE64_X86_KERNELS
 
-		char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-		char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-		char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+// ---- SSE4.1, 12 bytes <-> 16 characters per block (W. Mula / A. Klomp) ----
 
-		for (j = 0; (j < i + 1); j++)
-			ret += base64_chars[char_array_4[j]];
+__attribute__((target("ssse3,sse4.1")))
+static inline __m128i encodeReshuffle128(__m128i in) {
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+	const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+	const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+	const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+	return _mm_or_si128(t1, t3);
+}
 
-		while ((i++ < 3))
-			ret += '=';
+// 6 bit values -> characters, the offset to add is looked up by range
+__attribute__((target("ssse3,sse4.1")))
+static inline __m128i encodeTranslate128(__m128i in) {
+	const __m128i offsets = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+	__m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+	indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+	return _mm_add_epi8(in, _mm_shuffle_epi8(offsets, indices));
+}
 
+__attribute__((target("ssse3,sse4.1")))
+static size_t encodeSse41(const uint8_t *in, size_t len, char *out) {
+	size_t i = 0;
+	for (; i + 16 <= len; i += 12) {    // Loads 16 bytes, uses 12
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), encodeTranslate128(encodeReshuffle128(block)));
+		out += 16;
 	}
+	return i;
+}
 
-	return ret;
+// Characters -> 6 bit values, returns false if <block> has a character outside the alphabet
+__attribute__((target("ssse3,sse4.1")))
+static inline bool decodeTranslate128(__m128i &block) {
+	const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask2F = _mm_set1_epi8(0x2F);
+	const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(block, 4), mask2F);
+	const __m128i loNibbles = _mm_and_si128(block, mask2F);
+	if (!_mm_testz_si128(_mm_shuffle_epi8(lutLo, loNibbles), _mm_shuffle_epi8(lutHi, hiNibbles))) {
+		return false;
+	}
+	const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(block, mask2F), hiNibbles));
+	block = _mm_add_epi8(block, roll);
+	return true;
+}
 
+// Packs the four 6 bit values of every 32 bit lane into 3 bytes, at the bottom of the lane
+__attribute__((target("ssse3,sse4.1")))
+static inline __m128i decodePack128(__m128i values) {
+	const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+	return _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
 }
 
-std::string base64_decode(std::string const& encoded_string) {
-	size_t in_len = encoded_string.size();
-	int i = 0;
-	int j = 0;
-	int in_ = 0;
-	unsigned char char_array_4[4], char_array_3[3];
-	std::string ret;
-
-	while (in_len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-		char_array_4[i++] = encoded_string[in_]; in_++;
-		if (i == 4) {
-			for (i = 0; i <4; i++)
-				char_array_4[i] = base64_chars.find(char_array_4[i]) & 0xff;
-
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-			for (i = 0; (i < 3); i++)
-				ret += char_array_3[i];
-			i = 0;
+__attribute__((target("ssse3,sse4.1")))
+static size_t decodeSse41(const char *in, size_t len, uint8_t *out) {
+	const __m128i gather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	size_t i = 0;
+	for (; i + 24 <= len; i += 16) {    // Stores 16 bytes, uses 12. The output has room for them while 8 more characters follow
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		if (!decodeTranslate128(block)) {
+			break;
 		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(decodePack128(block), gather));
+		out += 12;
+	}
+	return i;
+}
+
+// ---- AVX2, 24 bytes <-> 32 characters per block, the SSE algorithm on both 128 bit lanes ----
+
+__attribute__((target("avx2")))
+static size_t encodeAvx2(const uint8_t *in, size_t len, char *out) {
+	const __m256i reshuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+	                                           1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m256i offsets = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+	                                         65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+	size_t i = 0;
+	for (; i + 28 <= len; i += 24) {    // Each lane loads 16 bytes and uses 12
+		const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+		__m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+		block = _mm256_shuffle_epi8(block, reshuffle);
+		const __m256i t1 = _mm256_mulhi_epu16(_mm256_and_si256(block, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+		const __m256i t3 = _mm256_mullo_epi16(_mm256_and_si256(block, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+		block = _mm256_or_si256(t1, t3);
+		__m256i indices = _mm256_subs_epu8(block, _mm256_set1_epi8(51));
+		indices = _mm256_sub_epi8(indices, _mm256_cmpgt_epi8(block, _mm256_set1_epi8(25)));
+		block = _mm256_add_epi8(block, _mm256_shuffle_epi8(offsets, indices));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), block);
+		out += 32;
 	}
+	return i;
+}
 
-	if (i) {
-		for (j = 0; j < i; j++)
-			char_array_4[j] = base64_chars.find(char_array_4[j]) & 0xff;
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const char *in, size_t len, uint8_t *out) {
+	const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+	                                       0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+	                                       0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+	                                         0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i gather = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+	                                        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i mask2F = _mm256_set1_epi8(0x2F);
+	size_t i = 0;
+	for (; i + 44 <= len; i += 32) {    // Stores 32 bytes, uses 24
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(block, 4), mask2F);
+		const __m256i loNibbles = _mm256_and_si256(block, mask2F);
+		if (!_mm256_testz_si256(_mm256_shuffle_epi8(lutLo, loNibbles), _mm256_shuffle_epi8(lutHi, hiNibbles))) {
+			break;
+		}
+		const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(block, mask2F), hiNibbles));
+		block = _mm256_add_epi8(block, roll);
+		block = _mm256_madd_epi16(_mm256_maddubs_epi16(block, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+		block = _mm256_shuffle_epi8(block, gather);
+		block = _mm256_permutevar8x32_epi32(block, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));    // Close the gap between the lanes
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), block);
+		out += 24;
+	}
+	return i;
+}
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
+// ---- AVX-512 VBMI, 48 bytes <-> 64 characters per block, byte permutes do the table lookups ----
 
-		for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+struct VbmiTables {
+	uint8_t encodeSplit[64];            // Input bytes of every 32 bit lane, in the order the multishift expects
+	uint8_t decodeLookup[128];          // ASCII -> 6 bit value, 0x80 for characters outside the alphabet
+	uint8_t decodeGather[64];           // Bytes 2, 1, 0 of every 32 bit lane, packed
+	constexpr VbmiTables() : encodeSplit(), decodeLookup(), decodeGather() {
+		for (int lane = 0; lane < 16; ++lane) {
+			encodeSplit[lane * 4 + 0] = static_cast<uint8_t>(lane * 3 + 1);
+			encodeSplit[lane * 4 + 1] = static_cast<uint8_t>(lane * 3 + 0);
+			encodeSplit[lane * 4 + 2] = static_cast<uint8_t>(lane * 3 + 2);
+			encodeSplit[lane * 4 + 3] = static_cast<uint8_t>(lane * 3 + 1);
+			decodeGather[lane * 3 + 0] = static_cast<uint8_t>(lane * 4 + 2);
+			decodeGather[lane * 3 + 1] = static_cast<uint8_t>(lane * 4 + 1);
+			decodeGather[lane * 3 + 2] = static_cast<uint8_t>(lane * 4 + 0);
+		}
+		for (int c = 0; c < 128; ++c) {
+			decodeLookup[c] = 0x80;
+		}
+		for (int i = 0; i < 64; ++i) {
+			decodeLookup[static_cast<uint8_t>(base64_chars[i])] = static_cast<uint8_t>(i);
+		}
 	}
+};
+static constexpr VbmiTables vbmiTables;
 
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static size_t encodeAvx512Vbmi(const uint8_t *in, size_t len, char *out) {
+	const __m512i split = _mm512_loadu_si512(vbmiTables.encodeSplit);
+	const __m512i alphabet = _mm512_loadu_si512(base64_chars);
+	const __m512i shifts = _mm512_set1_epi64(0x3036242a1016040aLL);   // Bit offsets of the four 6 bit fields in each lane
+	size_t i = 0;
+	for (; i + 64 <= len; i += 48) {    // Loads 64 bytes, uses 48
+		__m512i block = _mm512_loadu_si512(in + i);
+		block = _mm512_permutexvar_epi8(split, block);
+		block = _mm512_multishift_epi64_epi8(shifts, block);
+		_mm512_storeu_si512(out, _mm512_permutexvar_epi8(block, alphabet));
+		out += 64;
+	}
+	return i;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static size_t decodeAvx512Vbmi(const char *in, size_t len, uint8_t *out) {
+	const __m512i lookupLow = _mm512_loadu_si512(vbmiTables.decodeLookup);
+	const __m512i lookupHigh = _mm512_loadu_si512(vbmiTables.decodeLookup + 64);
+	const __m512i gather = _mm512_loadu_si512(vbmiTables.decodeGather);
+	size_t i = 0;
+	for (; i + 88 <= len; i += 64) {    // Stores 64 bytes, uses 48
+		const __m512i block = _mm512_loadu_si512(in + i);
+		const __m512i values = _mm512_permutex2var_epi8(lookupLow, block, lookupHigh);
+		if (_mm512_movepi8_mask(_mm512_or_si512(values, block)) != 0) {    // Not ASCII or not in the alphabet
+			break;
+		}
+		const __m512i packed = _mm512_madd_epi16(_mm512_maddubs_epi16(values, _mm512_set1_epi32(0x01400140)), _mm512_set1_epi32(0x00011000));
+		_mm512_storeu_si512(out, _mm512_permutexvar_epi8(gather, packed));
+		out += 48;
+	}
+	return i;
+}
+
+#endif  // BASE64_X86_KERNELS
+
+static size_t noBlocks(const uint8_t*, size_t, char*) { return 0; }
+static size_t noBlocks(const char*, size_t, uint8_t*) { return 0; }
+
+struct Base64Kernels {
+	EncodeBlocks encode;
+	DecodeBlocks decode;
+	const char *name;
+};
+
+static Base64Kernels selectKernels(void) {
+#ifdef BASE64_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("avx512bw")) {
+		return {encodeAvx512Vbmi, decodeAvx512Vbmi, "avx512vbmi"};
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return {encodeAvx2, decodeAvx2, "avx2"};
+	}
+	if (__builtin_cpu_supports("sse4.1")) {
+		return {encodeSse41, decodeSse41, "sse4.1"};
+	}
+#endif
+	return {noBlocks, noBlocks, "scalar"};
+}
+
+static const Base64Kernels& kernels(void) {
+	static const Base64Kernels selected = selectKernels();
+	return selected;
+}
+
+// =================================== Public API's ===================================
+
+size_t base64_encoded_length(size_t len) {
+	return (len + 2) / 3 * 4;
+}
+
+size_t base64_decoded_max_length(size_t len) {
+	return len / 4 * 3 + ((len % 4 > 1) ? len % 4 - 1 : 0);
+}
+
+size_t base64_encode_to(unsigned char const* in, size_t len, char* out) {
+	const size_t done = kernels().encode(in, len, out);
+	return done / 3 * 4 + encodeScalar(in + done, len - done, out + done / 3 * 4);
+}
+
+size_t base64_decode_to(char const* in, size_t len, unsigned char* out) {
+	const size_t done = kernels().decode(in, len, out);
+	return done / 4 * 3 + decodeScalar(in + done, len - done, out + done / 4 * 3);
+}
+
+const char* base64_implementation(void) {
+	return kernels().name;
+}
+
+std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
+	std::string ret(base64_encoded_length(in_len), '\0');
+	base64_encode_to(bytes_to_encode, in_len, &ret[0]);
 	return ret;
 }
 
-// std::string encodeBase64(const std::string& data, size_t size) {
-//     static const std::string base64Chars =
-//         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-// 
-//     std::string encodedData;
-// 
-//     size_t padding = size % 3;
-//     size_t length = size - padding;
-// 
-//     for (size_t i = 0; i < length; i += 3) {
-//         unsigned int value = (data[i] << 16) + (data[i + 1] << 8) + data[i + 2];
-//         encodedData += base64Chars[(value >> 18) & 63];
-//         encodedData += base64Chars[(value >> 12) & 63];
-//         encodedData += base64Chars[(value >> 6) & 63];
-//         encodedData += base64Chars[value & 63];
-//     }
-// 
-//     if (padding == 1) {
-//         unsigned int value = data[length];
-//         encodedData += base64Chars[(value >> 2) & 63];
-//         encodedData += base64Chars[(value << 4) & 63];
-//         encodedData += "==";
-//     } else if (padding == 2) {
-//         unsigned int value = (data[length] << 8) + data[length + 1];
-//         encodedData += base64Chars[(value >> 10) & 63];
-//         encodedData += base64Chars[(value >> 4) & 63];
-//         encodedData += base64Chars[(value << 2) & 63];
-//         encodedData += "=";
-//     }
-// 
-//     return encodedData;
-// }
-// 
-// std::string decodeBase64(const std::string& data, size_t size) {
-//     static const std::string base64Chars =
-//         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-// 
-//     std::string decodedData;
-// 
-//     size_t padding = 0;
-//     if (size > 0 && data[size - 1] == '=')
-//         padding++;
-//     if (size > 1 && data[size - 2] == '=')
-//         padding++;
-// 
-//     size_t length = ((size * 6) / 8) - padding;
-// 
-//     for (size_t i = 0; i < size; i += 4) {
-//         unsigned int value = 0;
-//         for (size_t j = 0; j < 4; j++) {
-//             value <<= 6;
-//             if (data[i + j] >= 'A' && data[i + j] <= 'Z')
-//                 value |= data[i + j] - 'A';
-//             else if (data[i + j] >= 'a' && data[i + j] <= 'z')
-//                 value |= data[i + j] - 'a' + 26;
-//             else if (data[i + j] >= '0' && data[i + j] <= '9')
-//                 value |= data[i + j] - '0' + 52;
-//             else if (data[i + j] == '+')
-//                 value |= 62;
-//             else if (data[i + j] == '/')
-//                 value |= 63;
-//         }
-// 
-//         for (size_t j = 0; j < 3; j++) {
-//             if (j < length)
-//                 decodedData += (value >> (16 - j * 8)) & 0xFF;
-//         }
-//     }
-// 
-//     return decodedData;
-// }
+std::string base64_decode(std::string const& encoded_string) {
+	std::string ret(base64_decoded_max_length(encoded_string.size()), '\0');
+	ret.resize(base64_decode_to(encoded_string.data(), encoded_string.size(), reinterpret_cast<unsigned char*>(&ret[0])));
+	return ret;
+}
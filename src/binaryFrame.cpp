@@ -0,0 +1,103 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "binaryFrame.h"
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+static void putUint(std::string &out, uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+static uint64_t getUint(const unsigned char *in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static uint8_t codingToFlags(Compression::Coding coding) {
+    switch (coding) {
+    case Compression::Coding::Deflate: return 1;
+    case Compression::Coding::Gzip: return 2;
+    case Compression::Coding::Zstd: return 3;
+    default: return 0;
+    }
+}
+
+static Compression::Coding flagsToCoding(uint8_t flags) {
+    switch (flags & BinaryFrame::FLAG_CODING_MASK) {
+    case 1: return Compression::Coding::Deflate;
+    case 2: return Compression::Coding::Gzip;
+    case 3: return Compression::Coding::Zstd;
+    default: return Compression::Coding::Identity;
+    }
+}
+
+
+// ============================ PUBLIC API ============================
+
+void BinaryFrame::append(std::string &out, Type type, uint64_t jobId, const std::string &payload, Compression::Coding coding) {
+    std::string compressed;
+    const bool useCompression = coding != Compression::Coding::Identity &&
+                                payload.size() >= Compression::MIN_COMPRESS_SIZE &&
+                                Compression::compress(coding, payload, compressed) &&
+                                compressed.size() < payload.size();
+    const std::string &data = useCompression ? compressed : payload;
+
+    out.reserve(out.size() + HEADER_SIZE + data.size());
+    putUint(out, data.size(), 4);
+    putUint(out, jobId, 8);
+    putUint(out, static_cast<uint8_t>(type), 1);
+    putUint(out, useCompression ? codingToFlags(coding) : 0, 1);
+    putUint(out, 0, 2);
+    out += data;
+}
+
+bool BinaryFrame::parse(const std::string &data, std::vector<BinaryFrame> &frames) {
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data.data());
+    size_t offset = 0;
+    while (offset < data.size()) {
+        if (data.size() - offset < HEADER_SIZE) {
+            return false;
+        }
+        const uint64_t length = getUint(in + offset, 4);
+        if (data.size() - offset - HEADER_SIZE < length) {
+            return false;
+        }
+        BinaryFrame frame;
+        frame.jobId = getUint(in + offset + 4, 8);
+        frame.type = static_cast<Type>(in[offset + 12]);
+        frame.flags = in[offset + 13];
+        frame.payload.assign(data, offset + HEADER_SIZE, length);
+        frames.push_back(std::move(frame));
+        offset += HEADER_SIZE + length;
+    }
+    return true;
+}
+
+bool BinaryFrame::decodePayload(std::string &decoded) const {
+    return Compression::decompress(flagsToCoding(flags), payload, decoded);
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "cancelToken.h"
+#include <signal.h>
+#include <algorithm>
+
+CancelToken::CancelToken(Clock::time_point deadline) : deadline(deadline) {
+}
+
+void CancelToken::cancel(void) {
+    cancelled = true;
+    killProcess();
+}
+
+bool CancelToken::isCancelled(void) const {
+    return cancelled;
+}
+
+bool CancelToken::isExpired(void) const {
+    return deadline != Clock::time_point::max() && Clock::now() >= deadline;
+}
+
+bool CancelToken::isStopped(void) const {
+    return isCancelled() || isExpired();
+}
+
+int CancelToken::remainingMs(int cap) const {
+    if (deadline == Clock::time_point::max()) {
+        return cap;
+    }
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return static_cast<int>(std::max<long long>(0, std::min<long long>(remaining, cap)));
+}
+
+void CancelToken::killProcess(void) {
+    std::lock_guard<std::mutex> lock(processMutex);
+    if (processGroup > 0) {
+        kill(-processGroup, SIGKILL);           // Whole group, so grandchildren (i.e. commands of a shell) die too
+    }
+}
+
+void CancelToken::attachProcess(pid_t pid) {
+    {
+        std::lock_guard<std::mutex> lock(processMutex);
+        processGroup = pid;
+    }
+    if (isStopped()) {                          // Stopped while the child was being started
+        killProcess();
+    }
+}
+
+void CancelToken::detachProcess(void) {
+    std::lock_guard<std::mutex> lock(processMutex);
+    processGroup = 0;
+}
+
+std::string CancelToken::stopReason(void) const {
+    if (isCancelled()) {
+        return "cancelled";
+    }
+    if (isExpired()) {
+        return "deadline exceeded";
+    }
+    return std::string();
+}
@@ -0,0 +1,159 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "clientConfig.h"
+#include "utilities.h"
+#include <iostream>
+#include <cstring>
+
+static bool parseNumber(const std::string &value, size_t &result) {
+	try {
+		size_t pos = 0;
+		const unsigned long number = std::stoul(value, &pos);
+		if (pos != value.size() || number == 0) {
+			return false;
+		}
+		result = number;
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	return true;
+}
+
+static bool parseMilliseconds(const std::string &value, unsigned long multiplier, std::chrono::milliseconds &result) {
+	try {
+		size_t pos = 0;
+		const unsigned long number = std::stoul(value, &pos);
+		if (pos != value.size() || number == 0) {
+			return false;
+		}
+		result = std::chrono::milliseconds(number * multiplier);
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	return true;
+}
+
+void printUsage(void) {
+	std::cout << "clientHTTP <URL/IP> <PORT> [options]\n"
+	          << "  --heartbeat=<secs>     heartbeat interval when idle (default 1)\n"
+	          << "  --max-idle=<secs>      upper bound of the idle back-off (default 8)\n"
+	          << "  --active-poll=<ms>     poll interval while jobs are running (default 50)\n"
+	          << "  --long-poll=<secs>     let the server hold each heartbeat up to <secs> until a job is queued\n"
+	          << "  --batch=<count>        send up to <count> queued responses in one request (default 1)\n"
+	          << "  --batch-bytes=<bytes>  byte budget of one batched request (default 1048576)\n"
+	          << "  --workers=<count>      threads executing jobs (default: usable CPUs, at least 2)\n"
+	          << "  --job-queue=<count>    jobs allowed to wait for a worker, per priority lane (default 64)\n"
+	          << "  --normal-workers=<n>   workers normal and bulk jobs may occupy together (default: all but one)\n"
+	          << "  --bulk-workers=<n>     workers bulk transfers may occupy (default: half of them)\n"
+	          << "  --job-timeout=<secs>   stop jobs without their own \"timeout\" after <secs> (default: never)\n"
+	          << "  --output-memory=<bytes>  command output kept in memory per job, the rest spills to disk (default 1048576)\n"
+	          << "  --response-queue=<bytes> queued response bytes at which large outputs wait for the sender (default 4194304)\n"
+	          << "  --upload-concurrency=<n> files a directory upload sends at the same time (default 4)\n"
+	          << "  --upload-rate=<bytes>    bytes per second all uploads together may send (default: unlimited)\n"
+	          << "  --download-segments=<n>  parallel range requests a large download is split into (default 1)" << std::endl;
+}
+
+bool parseArguments(int argc, char** argv, ClientConfig &config) {
+
+	if (argc < 3) {
+		printUsage();
+		return false;
+	}
+	config.url = argv[1];
+	config.port = argv[2];
+	if (!isValidPort(argv[2])) {
+		return false;
+	}
+
+	for (int i = 3; i < argc; ++i) {
+		const std::string arg {argv[i]};
+		const size_t eq = arg.find('=');
+		const std::string name = arg.substr(0, eq);
+		const std::string value = (eq == std::string::npos) ? std::string() : arg.substr(eq + 1);
+		bool ok = false;
+
+		if (name == "--heartbeat") {
+			ok = parseMilliseconds(value, 1000, config.heartbeatInterval);
+		}
+		else if (name == "--max-idle") {
+			ok = parseMilliseconds(value, 1000, config.maxIdleInterval);
+		}
+		else if (name == "--active-poll") {
+			ok = parseMilliseconds(value, 1, config.activeInterval);
+		}
+		else if (name == "--long-poll") {
+			std::chrono::milliseconds wait {0};
+			ok = parseMilliseconds(value, 1000, wait);
+			config.longPollWait = std::chrono::duration_cast<std::chrono::seconds>(wait);
+		}
+		else if (name == "--batch") {
+			ok = parseNumber(value, config.batchMaxCount);
+		}
+		else if (name == "--batch-bytes") {
+			ok = parseNumber(value, config.batchMaxBytes);
+		}
+		else if (name == "--workers") {
+			ok = parseNumber(value, config.workerThreads);
+		}
+		else if (name == "--job-queue") {
+			ok = parseNumber(value, config.jobQueueCapacity);
+		}
+		else if (name == "--normal-workers") {
+			ok = parseNumber(value, config.normalWorkers);
+		}
+		else if (name == "--bulk-workers") {
+			ok = parseNumber(value, config.bulkWorkers);
+		}
+		else if (name == "--job-timeout") {
+			std::chrono::milliseconds timeout {0};
+			ok = parseMilliseconds(value, 1000, timeout);
+			config.jobTimeout = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+		}
+		else if (name == "--output-memory") {
+			ok = parseNumber(value, config.outputMemoryLimit);
+		}
+		else if (name == "--response-queue") {
+			ok = parseNumber(value, config.responseQueueLimit);
+		}
+		else if (name == "--upload-concurrency") {
+			ok = parseNumber(value, config.uploadConcurrency);
+		}
+		else if (name == "--upload-rate") {
+			ok = parseNumber(value, config.uploadRateLimit);
+		}
+		else if (name == "--download-segments") {
+			ok = parseNumber(value, config.downloadSegments);
+		}
+		if (!ok) {
+			std::cerr << "Invalid option: " << arg << "\n";
+			printUsage();
+			return false;
+		}
+	}
+	if (config.maxIdleInterval < config.heartbeatInterval) {
+		config.maxIdleInterval = config.heartbeatInterval;
+	}
+	return true;
+}
@@ -0,0 +1,204 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "compression.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+// Is <coding> listed (and not with q=0) in an Accept-Encoding style list i.e. "gzip;q=0.5, deflate"
+static bool isAccepted(const std::string &acceptedCodings, const std::string &coding) {
+    std::string list = acceptedCodings;
+    std::transform(list.begin(), list.end(), list.begin(), ::tolower);
+    list.erase(std::remove_if(list.begin(), list.end(), ::isspace), list.end());
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        const std::string item = list.substr(start, end - start);
+        const size_t semicolon = item.find(';');
+        if (item.compare(0, semicolon, coding) == 0) {
+            const size_t q = item.find("q=", semicolon);
+            return semicolon == std::string::npos || q == std::string::npos || std::atof(item.c_str() + q + 2) > 0.0;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+#ifdef HAVE_ZLIB
+static bool zlibCompress(const std::string &input, std::string &output, int windowBits) {
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    output.resize(deflateBound(&stream, input.size()) + 18);     // + gzip header/trailer
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    const int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+static bool zlibDecompress(const std::string &input, std::string &output, int windowBits) {
+    z_stream stream = {};
+    if (inflateInit2(&stream, windowBits) != Z_OK) {
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    output.clear();
+    char buffer[64 * 1024];
+    int result;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END) {
+            break;
+        }
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (result != Z_STREAM_END);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static bool zstdCompress(const std::string &input, std::string &output) {
+    output.resize(ZSTD_compressBound(input.size()));
+    const size_t size = ZSTD_compress(&output[0], output.size(), input.data(), input.size(), 3);
+    if (ZSTD_isError(size)) {
+        return false;
+    }
+    output.resize(size);
+    return true;
+}
+
+static bool zstdDecompress(const std::string &input, std::string &output) {
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+        return false;
+    }
+    ZSTD_initDStream(stream);
+    ZSTD_inBuffer in = { input.data(), input.size(), 0 };
+    output.clear();
+    char buffer[64 * 1024];
+    size_t result = 1;
+    while (in.pos < in.size && result != 0) {
+        ZSTD_outBuffer out = { buffer, sizeof(buffer), 0 };
+        result = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(result)) {
+            break;
+        }
+        output.append(buffer, out.pos);
+    }
+    ZSTD_freeDStream(stream);
+    return result == 0;
+}
+#endif
+
+
+// ============================ PUBLIC API ============================
+
+std::string Compression::supportedCodings(void) {
+    std::string codings;
+#ifdef HAVE_ZSTD
+    codings += "zstd, ";
+#endif
+#ifdef HAVE_ZLIB
+    codings += "deflate, gzip, ";
+#endif
+    return codings + "identity";
+}
+
+Compression::Coding Compression::negotiate(const std::string &acceptedCodings) {
+    (void)acceptedCodings;                  // Unused in a build without codecs
+#ifdef HAVE_ZSTD
+    if (isAccepted(acceptedCodings, "zstd")) { return Coding::Zstd; }
+#endif
+#ifdef HAVE_ZLIB
+    if (isAccepted(acceptedCodings, "deflate")) { return Coding::Deflate; }
+    if (isAccepted(acceptedCodings, "gzip")) { return Coding::Gzip; }
+#endif
+    return Coding::Identity;
+}
+
+Compression::Coding Compression::fromName(const std::string &name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "deflate") { return Coding::Deflate; }
+    if (lower == "gzip" || lower == "x-gzip") { return Coding::Gzip; }
+    if (lower == "zstd") { return Coding::Zstd; }
+    return Coding::Identity;
+}
+
+const char* Compression::toName(Coding coding) {
+    switch (coding) {
+    case Coding::Deflate: return "deflate";
+    case Coding::Gzip: return "gzip";
+    case Coding::Zstd: return "zstd";
+    default: return "identity";
+    }
+}
+
+bool Compression::compress(Coding coding, const std::string &input, std::string &output) {
+    switch (coding) {
+#ifdef HAVE_ZLIB
+    case Coding::Deflate: return zlibCompress(input, output, 15);
+    case Coding::Gzip: return zlibCompress(input, output, 15 + 16);
+#endif
+#ifdef HAVE_ZSTD
+    case Coding::Zstd: return zstdCompress(input, output);
+#endif
+    case Coding::Identity: output = input; return true;
+    default: return false;
+    }
+}
+
+bool Compression::decompress(Coding coding, const std::string &input, std::string &output) {
+    switch (coding) {
+#ifdef HAVE_ZLIB
+    case Coding::Deflate:                                   // Some servers send raw deflate instead of the zlib format
+        return zlibDecompress(input, output, 15) || zlibDecompress(input, output, -15);
+    case Coding::Gzip: return zlibDecompress(input, output, 15 + 16);
+#endif
+#ifdef HAVE_ZSTD
+    case Coding::Zstd: return zstdDecompress(input, output);
+#endif
+    case Coding::Identity: output = input; return true;
+    default: return false;
+    }
+}
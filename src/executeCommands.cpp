@@ -20,124 +20,192 @@
 
 
 #include "executeCommands.h"
+#include "outputCapture.h"
 #include <unistd.h>
-#include <iconv.h>
 #include "stringUtil.h"
 #include <iostream>
 #include <sys/wait.h>
-#include <sstream>
 #include <cstring>
-
-std::wstring executeCommand::operator()(const std::wstring& shellType, const std::wstring& command, const std::wstring& args) {
-
-    // Create a pipe for IPC
+#include <poll.h>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <spawn.h>
+#include <fcntl.h>
+#include <csignal>
+
+void executeCommand::waitUntilExited(pid_t pid, CancelToken *token) {
+    if (token == nullptr) {
+        return;
+    }
+    while (true) {                      // WNOWAIT keeps the child a zombie, so its pid can't be reused before it is detached
+        siginfo_t info = {};
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == -1 && errno != EINTR) {
+            break;
+        }
+        if (info.si_pid == pid) {
+            break;
+        }
+        if (token->isStopped()) {
+            token->killProcess();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    token->detachProcess();
+}
+
+pid_t executeCommand::spawn(const std::vector<std::string>& argv, int outputFd, int &error) {
+    // Everything the child needs is built here, posix_spawn (clone + exec) doesn't copy the address space
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto &arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, outputFd, STDOUT_FILENO);   // Redirect stdout/stderr to the write end of the pipe
+    posix_spawn_file_actions_adddup2(&actions, outputFd, STDERR_FILENO);   // Both pipe ends are close-on-exec, the copies aren't
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);             // Workers block SIGINT/SIGTERM, commands must not inherit that
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setpgroup(&attributes, 0);                     // Lead a new process group, so the job can be stopped together with everything it started
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    extern char** environ;
+    pid_t pid = -1;
+    const bool searchPath = argv.front().find('/') == std::string::npos;
+    error = searchPath ? posix_spawnp(&pid, args[0], &actions, &attributes, args.data(), environ)
+                       : posix_spawn(&pid, args[0], &actions, &attributes, args.data(), environ);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    return (error == 0) ? pid : -1;
+}
+
+std::string executeCommand::operator()(const std::string& shellType, const std::string& command, const std::string& args, CancelToken *token, const OutputSink &sink) {
+    // Execute command on the supplied shell e.g. (/bin/sh)
+    const std::string shell = shellType.empty() ? std::string("/bin/sh") : shellType;
+    const std::string fullCommand = args.empty() ? command : command + " " + args;
+    return (*this)({shell, "-c", fullCommand}, token, sink);
+}
+
+std::string executeCommand::operator()(const std::vector<std::string>& argv, CancelToken *token, const OutputSink &sink) {
+
+    if (argv.empty()) {
+        return "";
+    }
+    // Create a pipe for IPC, close-on-exec so children spawned by other jobs don't keep it open
     int pipefd[2];
-    if (pipe(pipefd) == -1) {
+    if (pipe2(pipefd, O_CLOEXEC) == -1) {
         perror("pipe");
-        return L"";
+        return "";
     }
-    // Fork the process
-    pid_t pid = fork();
+    int error = 0;
+    const pid_t pid = spawn(argv, pipefd[1], error);
+    // Close the write end of the pipe
+    close(pipefd[1]);
     if (pid == -1) {
-        perror("fork");
-        return L"";
-    } 
-    else if (pid == 0) {    // Child process
-        // Close the read end of the pipe
         close(pipefd[0]);
+        return "execute: " + argv.front() + " failed: " + strerror(error);
+    }
+    if (token != nullptr) {
+        token->attachProcess(pid);
+    }
 
-        // Redirect stdout/stderr to the write end of the pipe
-        if(dup2(pipefd[1], STDOUT_FILENO) == -1){
-            return L"Redirection of stdout to pipe for child process failed";
-        }
-        if(dup2(pipefd[1], STDERR_FILENO) == -1){
-            return L"Redirection of stderr to pipe for child process failed";
+    // Read the output from the pipe
+    char buffer[4096];
+    OutputCapture capture;                  // Without a sink, a preview is returned if the child prints a lot
+    ssize_t bytesRead;
+
+    std::string pending;                    // Streaming: output not handed to the sink yet
+    CancelToken::Clock::time_point pendingSince;
+    auto flushPending = [&](bool everything) {
+        const size_t length = everything ? pending.size() : StringUtils::utf8CompleteLength(pending);
+        if (length > 0) {
+            sink(pending.substr(0, length));
+            pending.erase(0, length);
         }
-        std::wstring fullCommand = command + L" " + args;
-        int retValue;
-
-        // Extract the parent environment variables
-        extern char** environ;
-        std::vector<char*> envVariables;
-        for (char** env = environ; *env != nullptr; ++env) {
-            envVariables.push_back(*env);
+        pendingSince = CancelToken::Clock::now();
+    };
+
+    bool killed = false;
+    CancelToken::Clock::time_point killedAt;
+    while (true) {
+        int timeoutMs = -1;
+        if (token != nullptr) {             // Wake up at the deadline even if the child is silent
+            if (!killed && token->isStopped()) {
+                killed = true;
+                killedAt = CancelToken::Clock::now();
+                token->killProcess();       // The pipe reports EOF once the whole group is gone
+            }
+            if (killed && CancelToken::Clock::now() - killedAt > std::chrono::seconds(2)) {
+                break;                      // Something outside the group still holds the pipe, give up on the output
+            }
+            timeoutMs = killed ? 100 : token->remainingMs(1000);
         }
-        envVariables.push_back(nullptr); // Null-terminate the array
-
-        if(shellType.empty()){      // This branch is used to execute a program 
-            const char** execArgs = nullptr;
-            retValue = execve(StringUtils::wstring_to_utf8(command).c_str(), const_cast<char* const*>(execArgs), envVariables.data());          
+        if (sink && !pending.empty()) {     // Don't sit on a partial chunk while the child is quiet
+            const auto flushInMs = std::chrono::duration_cast<std::chrono::milliseconds>(pendingSince + std::chrono::milliseconds(STREAM_FLUSH_MS) - CancelToken::Clock::now()).count();
+            if (flushInMs <= 0) {
+                flushPending(false);
+                continue;
+            }
+            timeoutMs = (timeoutMs < 0) ? static_cast<int>(flushInMs) : std::min(timeoutMs, static_cast<int>(flushInMs));
         }
-        else{   // Execute command on the supplied shell e.g. (/bin/sh)
-            // Execute the command
-            std::vector<char*> shell = {strdup(StringUtils::wstring_to_utf8(shellType).c_str()), strdup("-c"), strdup(StringUtils::wstring_to_utf8(fullCommand).c_str()), nullptr};
-            retValue = execve(StringUtils::wstring_to_utf8(shellType).c_str(), shell.data(), envVariables.data());   
+        if (timeoutMs >= 0) {
+            struct pollfd pfd = {pipefd[0], POLLIN, 0};
+            if (poll(&pfd, 1, timeoutMs) <= 0) {
+                continue;
+            }
         }
-        if(retValue == -1){     // check for execve(..) error
-            char buff[50];
-            std::wcout << L"execute: " + fullCommand + L" returns : " + StringUtils::s2ws(strerror_r(errno, buff, sizeof(buff)));
-        }       
-        exit(retValue);
-    }
-    else {           // Parent process       
-        // Close the write end of the pipe
-        close(pipefd[1]);
-
-        // Read the output from the pipe
-        char buffer[1024];
-        std::wstring output;
-        ssize_t bytesRead;
-
-        // Create an iconv converter
-        iconv_t conv = iconv_open("WCHAR_T", "UTF-8");
-        if (conv == (iconv_t)-1) {
-            perror("iconv_open");
-            return L"iconv_open error!";
+        bytesRead = read(pipefd[0], buffer, sizeof(buffer));
+        if (bytesRead <= 0) {
+            if (bytesRead == -1 && errno == EINTR) {
+                continue;
+            }
+            break;
         }
-
-        while ((bytesRead = read(pipefd[0], buffer, sizeof(buffer))) > 0) {
-            // Convert the input buffer from UTF-8 to wide characters
-            char* inbuf = buffer;
-            size_t inbytesleft = bytesRead;
-            size_t outbytesleft = sizeof(buffer) * 4; // Wide characters can take up to 4 bytes
-
-            char outbuf[4096]; // Adjust the buffer size as needed
-            char* outptr = outbuf;
-
-            if (iconv(conv, &inbuf, &inbytesleft, &outptr, &outbytesleft) == (size_t)-1) {
-                perror("iconv");
-                break;
+        if (sink) {
+            if (pending.empty()) {
+                pendingSince = CancelToken::Clock::now();
             }
-
-            // Calculate the number of wide characters
-            size_t numWChars = (sizeof(buffer) * 4 - outbytesleft) / sizeof(wchar_t);
-
-            if (numWChars > 0) {
-                output.append(reinterpret_cast<wchar_t*>(outbuf), numWChars);
+            pending.append(buffer, bytesRead);
+            if (pending.size() >= STREAM_CHUNK_SIZE) {
+                flushPending(false);
             }
+            continue;
         }
+        capture.append(buffer, static_cast<size_t>(bytesRead));
+    }
 
-        // Close the iconv converter
-        iconv_close(conv);
+    if (sink && !pending.empty()) {
+        flushPending(true);
+    }
 
-        // Close the read end of the pipe
-        close(pipefd[0]);
+    // Close the read end of the pipe
+    close(pipefd[0]);
 
-        // Wait for the child process to exit
-        int status;
-        waitpid(pid, &status, 0);
-
-        if (WIFEXITED(status)) {
-            int exitStatus = WEXITSTATUS(status);
-            std::wstringstream ss;
-            ss << L" | Child process exited with status: " << exitStatus;
-            output += ss.str();
-        } else if (WIFSIGNALED(status)) {
-            int signalNumber = WTERMSIG(status);
-            std::wstringstream ss;
-            ss << L" | Child process terminated due to signal: " << signalNumber;
-            output += ss.str();
-        }
-        return output;
+    std::string output = capture.isSpilled() ? capture.getPreview() : capture.text();
+
+    // Wait for the child process to exit
+    int status = 0;
+    waitUntilExited(pid, token);
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+    }
+
+    if (WIFEXITED(status)) {
+        int exitStatus = WEXITSTATUS(status);
+        output += " | Child process exited with status: " + std::to_string(exitStatus);
+    } else if (WIFSIGNALED(status)) {
+        int signalNumber = WTERMSIG(status);
+        output += " | Child process terminated due to signal: " + std::to_string(signalNumber);
     }
+    return output;
 }
\ No newline at end of file
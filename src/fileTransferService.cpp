@@ -1,194 +1,424 @@
-#include <fstream>
 #include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <strings.h>
 #include "fileTransferService.h"
 #include "curl/curl.h"
+#include "transferEngine.h"
+#include "uploadPipeline.h"
+#include "partialDownload.h"
+#include "segmentedDownload.h"
 #include "stringUtil.h"
 
 // ============================ PRIVATE FUNCTIONS ============================
 
-size_t curlFileTransfer::WriteData(void* buffer, size_t size, size_t nmemb, void* userp) {
-    std::ofstream* file = static_cast<std::ofstream*>(userp);
-    file->write(static_cast<const char*>(buffer), size * nmemb);
-    return size * nmemb;
+// Called by curl at least once per second, a non-zero return aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+static int AbortIfStopped(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<const CancelToken*>(clientp)->isStopped() ? 1 : 0;
 }
 
-size_t curlFileTransfer::WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    return size * nmemb;
+static void setCancelToken(CURL* curl, CancelToken* token) {
+    if (token == nullptr) {
+        return;
+    }
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, AbortIfStopped);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, token);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
 }
 
-bool curlFileTransfer::isDataServerAvailable(const std::string& url) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        // std::cerr << "Curl initialization failed." << std::endl;
-        return false;
+// State of one request of a download
+struct DownloadAttempt {
+    CURL* curl;
+    PartialDownload& part;
+    int64_t offset;                 // Where the next body byte goes
+    bool started = false;           // The first body byte arrived and the response was accepted
+    bool restartNeeded = false;     // The file changed on the server, the data so far is useless
+    bool writeFailed = false;
+    DownloadHeaders headers;        // Of the last response
+    std::chrono::steady_clock::time_point savedAt;
+
+    DownloadAttempt(CURL* curl, PartialDownload& part, int64_t offset) : curl(curl), part(part), offset(offset) {}
+};
+
+static const std::chrono::seconds SAVE_INTERVAL {1};    // Progress lost when the client dies
+
+// Sync the data so far and record how much of it there is, a resumed download continues from there
+static bool saveDownloadProgress(DownloadAttempt& attempt) {
+    attempt.part.syncedSize = attempt.offset;
+    attempt.savedAt = std::chrono::steady_clock::now();
+    return attempt.part.saveState();
+}
+
+static size_t ReadDownloadHeader(char* buffer, size_t size, size_t nitems, void* userp) {
+    static_cast<DownloadAttempt*>(userp)->headers.parse(std::string(buffer, size * nitems));
+    return size * nitems;
+}
+
+// Decide on the first body byte whether the response continues the part file or replaces it
+static bool acceptDownloadResponse(DownloadAttempt& attempt, long status) {
+    PartialDownload& part = attempt.part;
+    const DownloadHeaders& headers = attempt.headers;
+    const std::string validator = headers.validator();
+    if (status == 206) {
+        const bool changed = (headers.rangeStart != attempt.offset) ||
+                             (part.totalSize >= 0 && headers.rangeTotal != part.totalSize) ||
+                             (!part.validator.empty() && !validator.empty() && validator != part.validator);
+        if (changed) {
+            attempt.restartNeeded = true;
+            return false;
+        }
+    }
+    else {                                          // The whole file, because it changed or the server ignores ranges
+        attempt.offset = 0;
+        if (!part.restart()) {
+            attempt.writeFailed = true;
+            return false;
+        }
+    }
+    if (!validator.empty()) {
+        part.validator = validator;
     }
+    part.totalSize = (status == 206) ? headers.rangeTotal : headers.contentLength;
+    if (!headers.sha256.empty()) {
+        part.sha256 = headers.sha256;
+    }
+    return saveDownloadProgress(attempt);
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L); // Suppress output
+static size_t WriteDownloadData(void* buffer, size_t size, size_t nmemb, void* userp) {
+    DownloadAttempt* attempt = static_cast<DownloadAttempt*>(userp);
+    long status = 0;
+    curl_easy_getinfo(attempt->curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 200 && status != 206) {
+        return size * nmemb;                        // Error page, the status decides what happens next
+    }
+    if (!attempt->started) {
+        if (!acceptDownloadResponse(*attempt, status)) {
+            return 0;                               // Aborts the transfer with CURLE_WRITE_ERROR
+        }
+        attempt->started = true;
+    }
+    if (!attempt->part.write(attempt->offset, static_cast<const char*>(buffer), size * nmemb)) {
+        attempt->writeFailed = true;
+        return 0;
+    }
+    attempt->offset += static_cast<int64_t>(size * nmemb);
+    if (std::chrono::steady_clock::now() - attempt->savedAt >= SAVE_INTERVAL && !saveDownloadProgress(*attempt)) {
+        attempt->writeFailed = true;
+        return 0;
+    }
+    return size * nmemb;
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    long responseCode;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+// One request for the missing part of the file
+curlFileTransfer::FetchResult curlFileTransfer::fetchMissingPart(const std::string& url, PartialDownload& part, std::string& errorMsg, CancelToken* token) {
+    const int64_t offset = part.size();
+    if (offset > 0 && offset == part.totalSize) {
+        return FetchResult::Complete;               // Finished just before the client stopped last time
+    }
+    TransferHandle handle;
+    if (!handle) {
+        errorMsg = "Failed to initialize libcurl";
+        return FetchResult::Failed;
+    }
+    CURL* curl = handle.get();
+    DownloadAttempt attempt(curl, part, offset);
 
-    curl_easy_cleanup(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, ReadDownloadHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &attempt);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteDownloadData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &attempt);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);        // A connection silent for a minute is retried
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+    setCancelToken(curl, token);
+    struct curl_slist* headers = nullptr;
+    const std::string range = std::to_string(offset) + "-";
+    if (offset > 0) {
+        // CURLOPT_RANGE rather than RESUME_FROM, which refuses the full 200 reply If-Range asks for when the file changed
+        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+        if (!part.validator.empty()) {
+            headers = curl_slist_append(headers, ("If-Range: " + part.validator).c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        }
+    }
 
-    if (res == CURLE_OK && responseCode == 200) {
-        return true;  // Port is open and responded with a 200 OK.
+    const CURLcode res = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (attempt.started && !attempt.writeFailed && !attempt.restartNeeded && !saveDownloadProgress(attempt)) {
+        attempt.writeFailed = true;
     }
 
-    return false;  // Port is either closed or didn't respond as expected.
+    if (attempt.writeFailed) {
+        errorMsg = "Couldn't write " + url.substr(url.find_last_of('/') + 1) + ".part";
+        return FetchResult::Failed;
+    }
+    if (attempt.restartNeeded) {
+        errorMsg = "file changed on the server";
+        return part.restart() ? FetchResult::Retry : FetchResult::Failed;
+    }
+    if (status == 416 && offset > 0) {              // Nothing left to send, or the file shrank
+        if (attempt.headers.rangeTotal == offset) {
+            return FetchResult::Complete;
+        }
+        errorMsg = "file changed on the server";
+        return part.restart() ? FetchResult::Retry : FetchResult::Failed;
+    }
+    if (status >= 400) {
+        errorMsg = "HTTP " + std::to_string(status);
+        return (status == 408 || status == 429 || status >= 500) ? FetchResult::Retry : FetchResult::Failed;
+    }
+    if (res != CURLE_OK) {
+        errorMsg = curl_easy_strerror(res);
+        return FetchResult::Retry;                  // Network trouble, the next attempt continues from here
+    }
+    if (status != 200 && status != 206) {
+        errorMsg = "HTTP " + std::to_string(status);
+        return FetchResult::Failed;
+    }
+    if (!attempt.started && !acceptDownloadResponse(attempt, status)) {   // Empty body
+        errorMsg = "Couldn't write " + url.substr(url.find_last_of('/') + 1) + ".part";
+        return FetchResult::Failed;
+    }
+    if (part.totalSize >= 0 && attempt.offset != part.totalSize) {
+        errorMsg = "connection closed early";
+        return FetchResult::Retry;
+    }
+    return FetchResult::Complete;
 }
 
+// Probe the file with HEAD and fetch it over several connections if it is large enough and the server serves ranges
+curlFileTransfer::FetchResult curlFileTransfer::fetchSegments(const std::string& url, PartialDownload& part, size_t connections, std::string& errorMsg, CancelToken* token) {
+    if (!part.isSegmented() && part.size() > 0 && part.size() == part.totalSize) {
+        return FetchResult::Complete;
+    }
+    TransferHandle handle;
+    if (!handle) {
+        errorMsg = "Failed to initialize libcurl";
+        return FetchResult::Failed;
+    }
+    CURL* curl = handle.get();
+    DownloadAttempt probe(curl, part, 0);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, ReadDownloadHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &probe);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    setCancelToken(curl, token);
+    const CURLcode res = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status >= 400) {
+        errorMsg = "HTTP " + std::to_string(status);
+        return (status == 408 || status == 429 || status >= 500) ? FetchResult::Retry : FetchResult::Failed;
+    }
+    if (res != CURLE_OK) {
+        errorMsg = curl_easy_strerror(res);
+        return FetchResult::Retry;
+    }
+
+    const DownloadHeaders& headers = probe.headers;
+    const int64_t length = headers.contentLength;
+    if (!headers.acceptsRanges || length < 2 * SegmentedDownload::MIN_SEGMENT_SIZE) {
+        // Small, or the server can only send it whole
+        if (part.isSegmented() && !part.restart()) {
+            errorMsg = "Couldn't write " + url.substr(url.find_last_of('/') + 1) + ".part";
+            return FetchResult::Failed;
+        }
+        return fetchMissingPart(url, part, errorMsg, token);
+    }
+    const std::string validator = headers.validator();
+    if (!part.isSegmented() || part.totalSize != length || part.validator != validator) {
+        // A single stream download of the same file is continued from where it stopped, anything else starts over
+        const bool sameFile = !part.isSegmented() && part.totalSize == length && !validator.empty() && part.validator == validator;
+        const int64_t present = sameFile ? part.size() : 0;
+        if (!sameFile && !part.restart()) {
+            errorMsg = "Couldn't write " + url.substr(url.find_last_of('/') + 1) + ".part";
+            return FetchResult::Failed;
+        }
+        part.validator = validator;
+        part.totalSize = length;
+        if (!headers.sha256.empty()) {
+            part.sha256 = headers.sha256;
+        }
+        part.pendingRanges.assign(1, std::make_pair(present, length));
+        // The state goes first, a preallocated file must never pass for a complete single stream download
+        if (!part.saveState() || !part.preallocate(length)) {
+            errorMsg = "Not enough disk space for " + url.substr(url.find_last_of('/') + 1);
+            return FetchResult::Failed;
+        }
+    }
 
+    connections = std::min<size_t>(connections, static_cast<size_t>(length / SegmentedDownload::MIN_SEGMENT_SIZE));
+    SegmentedDownload download(url, part, connections, token);
+    switch (download.run(errorMsg)) {
+        case SegmentedDownload::Result::Complete:
+            return FetchResult::Complete;
+        case SegmentedDownload::Result::Retry:
+            return FetchResult::Retry;
+        case SegmentedDownload::Result::RangesUnsupported:
+            if (!part.restart()) {
+                errorMsg = "Couldn't write " + url.substr(url.find_last_of('/') + 1) + ".part";
+                return FetchResult::Failed;
+            }
+            return fetchMissingPart(url, part, errorMsg, token);
+        default:
+            return FetchResult::Failed;
+    }
+}
 
 // ============================ PUBLIC API ============================
 
-bool curlFileTransfer::DownloadFileFromURL(const std::wstring& url, const std::wstring& outputDirPath) {
+bool curlFileTransfer::DownloadFileFromURL(const std::string& url, const std::string& outputDirPath, const std::string& expectedSha256, size_t segments, std::string& errorMsg, CancelToken *token) {
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        //std::cerr << "Failed to initialize libcurl" << std::endl;
+    std::string outputFilePath = outputDirPath + "/" + url.substr(url.find_last_of('/') + 1);
+    PartialDownload part(outputFilePath);
+    int64_t resumeOffset = 0;
+    if (!part.open(url, resumeOffset)) {
+        errorMsg = "Failed to open output file: " + outputFilePath + ".part";
+        std::cerr << errorMsg << std::endl;
         return false;
     }
-    std::wstring outputFilePath = outputDirPath + L"/" + url.substr(url.find_last_of(L'/') + 1);
-    std::ofstream outputFile(fs::path(outputFilePath), std::ios::binary);
-    if (!outputFile) {
-        std::wcerr << "Failed to open output file: " << outputFilePath << std::endl;
-        curl_easy_cleanup(curl);
+
+    FetchResult result = FetchResult::Retry;
+    for (int attempt = 0; result == FetchResult::Retry && attempt < MAX_DOWNLOAD_ATTEMPTS; ++attempt) {
+        if (attempt > 0) {
+            // Back off 1, 2, 4 ... seconds, the part file keeps what arrived so far
+            const auto retryAt = std::chrono::steady_clock::now() + std::chrono::seconds(1 << (attempt - 1));
+            while (std::chrono::steady_clock::now() < retryAt && !(token != nullptr && token->isStopped())) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        if (token != nullptr && token->isStopped()) {
+            errorMsg = "job " + token->stopReason();
+            return false;                           // Kept for the next attempt to resume
+        }
+        if (segments > 1 || part.isSegmented()) {
+            result = fetchSegments(url, part, std::max<size_t>(segments, 1), errorMsg, token);
+        }
+        else {
+            result = fetchMissingPart(url, part, errorMsg, token);
+        }
+    }
+    if (result != FetchResult::Complete) {
+        std::cerr << "Failed to download file: " << errorMsg << std::endl;
+        if (result == FetchResult::Failed) {
+            part.discard();
+        }
         return false;
     }
-    std::string url_stdstring = StringUtils::ws2s(url);
-
-    curl_easy_setopt(curl, CURLOPT_URL, url_stdstring.c_str());
-    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteData);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &outputFile);
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L); // Suppress output
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        std::wcerr << "Failed to download file: " << curl_easy_strerror(res) << std::endl;
-        curl_easy_cleanup(curl);
-        outputFile.close();
-        std::error_code ec;
-        fs::remove(outputFilePath.c_str(), ec);  // Remove the partially downloaded file
-        return false;        
+    const std::string& sha256 = !expectedSha256.empty() ? expectedSha256 : part.sha256;
+    if (!sha256.empty() && strcasecmp(part.computeSha256().c_str(), sha256.c_str()) != 0) {
+        errorMsg = "SHA-256 mismatch";
+        part.discard();
+        return false;
+    }
+    if (!part.finalize()) {
+        errorMsg = "Couldn't rename " + outputFilePath + ".part";
+        return false;
     }
-    curl_easy_cleanup(curl);
-    outputFile.close();
     return true;
 }
 
-bool curlFileTransfer::DownloadDirectoryFromURL(const std::wstring& url, const std::wstring& outputDirPath) {
+bool curlFileTransfer::DownloadDirectoryFromURL(const std::string& /*url*/, const std::string& /*outputDirPath*/) {
     
     // To be implemented Later
     
     return false;
 }
 
-bool curlFileTransfer::UploadFileToURL(const std::wstring& url, const std::wstring& filePath) {
-
-    // Open the file for reading
-    std::ifstream fileStream(fs::path(filePath), std::ios::binary);
-    if (!fileStream.is_open()) {
-        // Handle file opening failure
-        return false;
-    }
-    // Get the file size
-    fileStream.seekg(0, std::ios::end);
-    std::streampos fileSize = fileStream.tellg();
+bool curlFileTransfer::UploadFileToURL(const std::string& url, const std::string& filePath, CancelToken *token) {
+    UploadPipeline pipeline(url, 1, token);
+    pipeline.push(filePath);
+    pipeline.close();
+    bool uploaded = false;
+    pipeline.run([&uploaded](const UploadResult& result) {
+        uploaded = result.succeeded();
+        return true;
+    });
+    return uploaded;
+}
 
-    if (fileSize == 0) { return false; } // Don't proceed if size is ZERO
+bool curlFileTransfer::UploadDirectoryToURL(const std::string& url, const std::string& dirPath, std::string &errorMsg, const std::string& extensions, std::string &report, CancelToken *token) {
 
-    fileStream.seekg(0, std::ios::beg);
+    UploadPipeline pipeline(url, TransferEngine::getUploadConcurrency(), token);
+    std::vector<std::string> extensions_vec = StringUtils::extract_items_from_str(extensions,",");
+    bool walkFailed = false;
 
-    // Allocate memory for the file content
-    std::vector<char> fileBuffer(fileSize);
+    // Walk the tree while the files found so far are being uploaded
+    std::thread walker([&]() {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dirPath, fs::directory_options::skip_permission_denied, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            const fs::directory_entry& entry = *it;
+            fs::status(entry, ec).type();    // To get error_code status
+            if (ec) {
+                break;
+            }
+            if (!fs::is_regular_file(entry, ec)) {
+                continue;
+            }
+            bool wanted = extensions.empty();
+            const std::string extension = entry.path().extension().string();
+            for (const auto& ext : extensions_vec) {
+                if (ext == extension) {
+                    wanted = true;
+                    break;
+                }
+            }
+            if (wanted && !pipeline.push(entry.path().string())) {
+                break;                                  // Uploads were stopped
+            }
+        }
+        walkFailed = static_cast<bool>(ec);
+        pipeline.close();
+    });
+
+    size_t uploaded = 0;
+    size_t failed = 0;
+    bool unreachable = false;
+    std::string failures;
+    pipeline.run([&](const UploadResult& result) {
+        if (result.succeeded()) {
+            ++uploaded;
+            return true;
+        }
+        if (result.code == CURLE_COULDNT_RESOLVE_HOST || result.code == CURLE_COULDNT_CONNECT) {
+            unreachable = true;                         // No point in trying the other files
+            return false;
+        }
+        if (++failed <= MAX_REPORTED_FAILURES) {
+            failures += "\n" + result.filePath + ": " + result.error;
+        }
+        return true;
+    });
+    walker.join();
 
-    // Read the file content into the buffer
-    if (!fileStream.read(fileBuffer.data(), fileSize)) {
-        // Handle file reading failure
-        return false;
+    report = std::to_string(uploaded) + " of " + std::to_string(uploaded + failed) + " files uploaded";
+    if (failed > MAX_REPORTED_FAILURES) {
+        failures += "\n... and " + std::to_string(failed - MAX_REPORTED_FAILURES) + " more";
     }
-    fileStream.close();
-
-    // Extract file name
-    std::wstring filename = StringUtils::extractFilename(filePath);
-
-    // Convert the wstring filename to UTF-8 encoded C-style string
-    std::string filenameUtf8 = StringUtils::convertWStringToUTF8(filename);
+    report += failures;
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        std::cerr << "curl_easy_init() failed!" << std::endl;
+    if (unreachable) {
+        errorMsg = "Couldn't connect to Data Server i.e " + url;
         return false;
     }
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L); // Suppress output
-    struct curl_httppost* formPost = nullptr;
-    struct curl_httppost* lastPtr = nullptr;
-
-    CURLFORMcode formAddResult = curl_formadd(&formPost, &lastPtr,
-        CURLFORM_COPYNAME, "file",
-        CURLFORM_BUFFER, filenameUtf8.c_str(),
-        CURLFORM_BUFFERPTR, fileBuffer.data(),
-        CURLFORM_BUFFERLENGTH, fileBuffer.size(),
-        CURLFORM_END);
-
-    if (formAddResult != CURL_FORMADD_OK) {
-    //    errorMsg = L"Failed to add form data: " + StringUtils::s2ws(curl_easy_strerror((CURLcode)formAddResult));
-        std::wcerr << L"Failed to add form data: " << StringUtils::s2ws(curl_easy_strerror((CURLcode)formAddResult)) << std::endl;
-        curl_easy_cleanup(curl);
+    if (token != nullptr && token->isStopped()) {
+        errorMsg = "job " + token->stopReason();
         return false;
     }
-
-    curl_easy_setopt(curl, CURLOPT_HTTPPOST, formPost);
-    curl_easy_setopt(curl, CURLOPT_URL, StringUtils::ws2s(url).c_str());
-
-   // Capture server response [ If not used, the CURL will prompts the server response on STDOUT ]
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        curl_easy_cleanup(curl);
+    if (walkFailed) {
+        errorMsg = "Couldn't read all of " + dirPath;
         return false;
     }
-    curl_easy_cleanup(curl);
-    return true;
-}
-
-bool curlFileTransfer::UploadDirectoryToURL(const std::wstring& url, const std::wstring& dirPath, std::wstring &errorMsg, const std::wstring& extensions) {
-
-    if(!isDataServerAvailable(StringUtils::ws2s(url))){
-        errorMsg = L"Couldn't connect to Data Server i.e " + url;
+    if (failed > 0) {
+        errorMsg = std::to_string(failed) + " files failed";
         return false;
     }
-    std::vector<std::wstring> filesToUpload;
-    std::vector<std::string> extensions_vec = StringUtils::extract_items_from_str(StringUtils::ws2s(extensions),",");
-    std::error_code ec;
-    for (const auto& entry : fs::recursive_directory_iterator(dirPath, fs::directory_options::skip_permission_denied, ec)) {
-        fs::status(entry, ec).type();    // To get error_code status
-        if(!ec) {
-            if (fs::is_regular_file(entry, ec)) {            
-                std::wstring filePath = entry.path().wstring();
-                if (extensions.empty()) {
-                    filesToUpload.push_back(filePath);
-                } 
-                else {
-                    std::string extension = entry.path().extension().string();                
-                    for(auto ext : extensions_vec){                
-                        if(ext == extension){ 
-                            filesToUpload.push_back(filePath);
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-        else { return false; }       
-    }
-    for (const auto& filePath : filesToUpload) {
-        UploadFileToURL(url, filePath);
-    }  
     return true;
 }
@@ -21,161 +21,321 @@
 
 
 #include "http.h"
+#include "httpResponseParser.h"
+#include "binaryFrame.h"
 #include <iostream>
-#include <arpa/inet.h>
-#include <netdb.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
 #include <unistd.h>
 #include "utilities.h"
 #include "json.h"
 #include <chrono>
-#include <thread>
-#include "stringUtil.h"
+#include <algorithm>
+#include "resolverCache.h"
 
 // ============================ PRIVATE FUNCTIONS ============================
 
-int HttpPost::createTcpSocket(void){
-        /* Build the socket. */
-    struct protoent* protoent = getprotobyname("tcp");
-    if (protoent == NULL) {
-        perror("getprotobyname");
-        return -1;
-    }
-    tcpSocket = socket(AF_INET, SOCK_STREAM, protoent->p_proto);
-    if (tcpSocket == -1) {
+int HttpPost::createTcpSocket(int family){
+    /* Build a non-blocking socket, connect() is raced and timed out by connectTcp(). */
+    LINUX_SOCKET_FD fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd == -1) {
         perror("socket");
-        return -1;
     }
-    return 0;
+    return fd;
 }
 
-int HttpPost::connectTcp(const std::wstring &url, const std::wstring &port){
-    /* Build the address. */
-    struct hostent *hostent = gethostbyname(StringUtils::ws2s(url).c_str());
-    if (hostent == NULL) {
-        std::wcerr << "error: gethostbyname(\"" << url << "\")" << std::endl;
-        return -1;
-    }
-    in_addr_t in_addr = inet_addr(inet_ntoa(*(struct in_addr*)*(hostent->h_addr_list)));
-    if (in_addr == (in_addr_t)-1) {
-        std::cerr << "error: inet_addr(\"" << *(hostent->h_addr_list) << "\")" << std::endl;
-        return -1;
+int HttpPost::connectTcp(const std::string &url, const std::string &port){
+    /* Resolve (cached), then race the addresses Happy-Eyeballs style (RFC 8305). */
+    std::vector<ResolvedAddress> addresses;
+    if (!ResolverCache::resolve(url, port, std::chrono::milliseconds(RESOLVE_TIMEOUT_MS), addresses)) {
+        return -2;
     }
-    struct sockaddr_in sockaddr_in;
-    const unsigned short server_port = std::stoi(port);
-    sockaddr_in.sin_addr.s_addr = in_addr;
-    sockaddr_in.sin_family = AF_INET;
-    sockaddr_in.sin_port = htons(server_port);
 
-    /* connect. */
-    if (connect(tcpSocket, (struct sockaddr*)&sockaddr_in, sizeof(sockaddr_in)) == -1) {
-        //perror("connect");
-        close(tcpSocket);
+    std::vector<struct pollfd> attempts;
+    size_t nextAddress = 0;
+    LINUX_SOCKET_FD connected = -1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+    auto nextAttemptAt = std::chrono::steady_clock::now();
+
+    while (connected == -1) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        // Start the next attempt when the previous ones are slow, or all of them have failed already
+        if (nextAddress < addresses.size() && (now >= nextAttemptAt || attempts.empty())) {
+            const ResolvedAddress &address = addresses[nextAddress++];
+            LINUX_SOCKET_FD fd = createTcpSocket(address.family);
+            if (fd != -1) {
+                if (connect(fd, reinterpret_cast<const struct sockaddr*>(&address.address), address.length) == 0) {
+                    connected = fd;
+                    break;
+                }
+                if (errno == EINPROGRESS) {
+                    attempts.push_back({ fd, POLLOUT, 0 });
+                }
+                else {
+                    close(fd);
+                }
+            }
+            nextAttemptAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(ATTEMPT_DELAY_MS);
+            continue;
+        }
+        if (attempts.empty()) {                 // Every address failed
+            break;
+        }
+        const auto waitUntil = (nextAddress < addresses.size()) ? std::min(nextAttemptAt, deadline) : deadline;
+        const int waitMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(waitUntil - now).count()) + 1;
+        if (poll(attempts.data(), attempts.size(), waitMs) == -1 && errno != EINTR) {
+            break;
+        }
+        for (size_t i = 0; i < attempts.size(); ) {
+            if (attempts[i].revents == 0) {
+                ++i;
+                continue;
+            }
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (connected == -1 && getsockopt(attempts[i].fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                connected = attempts[i].fd;
+            }
+            else {
+                close(attempts[i].fd);
+            }
+            attempts.erase(attempts.begin() + i);
+        }
+    }
+    for (const auto &attempt : attempts) {      // Losers of the race
+        close(attempt.fd);
+    }
+    if (connected == -1) {
+        ResolverCache::invalidate(url, port);       // Server may have moved, resolve again next time
         return -2;
     }
+
+    // Reads and writes are guarded by poll() (writes use MSG_DONTWAIT), the socket itself goes back to blocking mode
+    fcntl(connected, F_SETFL, fcntl(connected, F_GETFL) & ~O_NONBLOCK);
+    tcpSocket = connected;
+    state = ConnectionState::Connected;
+    connectedUrl = url;
+    connectedPort = port;
+    lastActivity = std::chrono::steady_clock::now();
+    return 0;
 }
 
-int HttpPost::sendHttpRequest(const std::wstring &request){
-    ssize_t nbytes_total;
-    ssize_t nbytes_last;
-    size_t request_len = request.length();
-
-    /* Send HTTP request. */
-    nbytes_total = 0;
-    while (nbytes_total < request_len) {            // send data to server
-        std::wstring wideChunk = request.substr(nbytes_total);
-        std::string narrowChunk = StringUtils::ws2s(wideChunk);
-        size_t narrowBytesToSend = narrowChunk.length();  
-        int nbytes_last = write(tcpSocket, narrowChunk.c_str(), static_cast<int>(narrowBytesToSend));
-        if (nbytes_last == -1) {       
-            close(tcpSocket);
+int HttpPost::sendHttpRequest(const HttpRequest &request){
+    /* Send header and body in one gather write, partial writes only advance the buffer pointers. */
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(request.header.data());
+    iov[0].iov_len = request.header.size();
+    iov[1].iov_base = const_cast<char*>(request.body.data());
+    iov[1].iov_len = request.body.size();
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    while (msg.msg_iovlen > 0) {
+        // A peer that stops reading fills the send buffer, don't wait for it forever
+        struct pollfd pfd = { tcpSocket, POLLOUT, 0 };
+        const int poll_result = poll(&pfd, 1, WRITE_TIMEOUT_MS);
+        if (poll_result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (poll_result <= 0) {
+            closeConnection();
+            return -1;
+        }
+        ssize_t nbytes_last = sendmsg(tcpSocket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (nbytes_last == -1) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            closeConnection();
             return -1;
-            //return std::wstring();
         }
-            nbytes_total += nbytes_last; // Increment by the number of bytes sent
+        size_t sent = static_cast<size_t>(nbytes_last);
+        while (msg.msg_iovlen > 0 && sent >= msg.msg_iov->iov_len) {     // Skip the fully sent buffers
+            sent -= msg.msg_iov->iov_len;
+            ++msg.msg_iov;
+            --msg.msg_iovlen;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = static_cast<char*>(msg.msg_iov->iov_base) + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
     }
+    return 0;
 }
 
-std::wstring HttpPost::recvHttpResponse(void){
-    /* Read the response with timeout. */
-    char readBuff[READ_BUFFER_SIZE] = {};
-    ssize_t nbytes=0;
-
-    fd_set read_fds;
-    FD_ZERO(&read_fds);
-    FD_SET(tcpSocket, &read_fds);
+int HttpPost::recvHttpResponse(HttpResponseParser &response, int firstByteTimeoutMs, bool &closedByServer){
+    /* Read the response with timeout, until the parser reports a complete message. */
+    char readBuff[READ_BUFFER_SIZE];
+    ssize_t nbytes = 0;
+    bool firstByte = true;
+    HttpResponseParser::Result result = HttpResponseParser::Result::NeedMore;
+    response.reset();
+    closedByServer = false;
 
-    struct timeval selectTimeout;
-    selectTimeout.tv_sec = 0; 
-    selectTimeout.tv_usec = 500 * 1000;		// 500 miliseconds
+    while (result == HttpResponseParser::Result::NeedMore) {
+        struct pollfd pfd = { tcpSocket, POLLIN, 0 };
+        int poll_result = poll(&pfd, 1, firstByte ? firstByteTimeoutMs : READ_TIMEOUT_MS);
+        if (poll_result <= 0) {             // Error or timeout, the connection is in unknown state now
+            closeConnection();
+            return -1;
+        }
+        nbytes = read(tcpSocket, readBuff, sizeof(readBuff));
+        if (nbytes == -1) {
+            perror("read");
+            closeConnection();
+            return -1;
+        }
+        if (nbytes == 0) {                  // Server closed the connection
+            closedByServer = firstByte;
+            result = response.finish();
+            break;
+        }
+        firstByte = false;
+        size_t consumed = 0;
+        result = response.feed(readBuff, nbytes, consumed);
+        if (consumed != static_cast<size_t>(nbytes)) {      // Unsolicited bytes after the response, don't trust this connection anymore
+            closeConnection();
+        }
+    }
+    if (result != HttpResponseParser::Result::Complete) {
+        closeConnection();
+        return -1;
+    }
+    if (!response.isKeepAlive()) {
+        closeConnection();
+    }
+    else {
+        lastActivity = std::chrono::steady_clock::now();
+    }
+    return 0;
+}
 
-    std::string tmpDataRead;
-    int select_result = select(tcpSocket + 1, &read_fds, NULL, NULL, &selectTimeout);
-    if (select_result == -1) {
-    //    perror("select");
-        close(tcpSocket);
-        return std::wstring();
+bool HttpPost::isConnectionReusable(const std::string &url, const std::string &port){
+    if (state != ConnectionState::Connected) {
+        return false;
     }
-    else if (select_result == 0) {
-        // Timeout occurred, if no data received within 2 seconds
-        //std::cout << "Timeout occurred. No data received within 2 seconds." << std::endl;
-        close(tcpSocket);
-        return std::wstring();
+    if (url != connectedUrl || port != connectedPort) {
+        return false;
     }
-    if (FD_ISSET(tcpSocket, &read_fds)) {
-        while ((nbytes = read(tcpSocket, readBuff, READ_BUFFER_SIZE)) > 0) {
-            // Process the received data
-            //write(STDOUT_FILENO, readBuff, nbytes);
-            readBuff[nbytes] = 0x00;
-            tmpDataRead += readBuff;
-        }
+    if (std::chrono::steady_clock::now() - lastActivity > IDLE_TIMEOUT) {
+        return false;
     }
-    if (nbytes == -1) {
-        perror("read");
+    // An idle connection must not be readable, otherwise the server has closed it (EOF) or sent garbage
+    struct pollfd pfd = { tcpSocket, POLLIN, 0 };
+    if (poll(&pfd, 1, 0) != 0) {
+        return false;
+    }
+    return true;
+}
+
+void HttpPost::closeConnection(void){
+    if (tcpSocket != -1) {
         close(tcpSocket);
-        return std::wstring();
+        tcpSocket = -1;
     }
-    return StringUtils::s2ws(tmpDataRead);
+    state = ConnectionState::Disconnected;
 }
 
 
 // ============================ PUBLIC API ============================
 
-std::wstring HttpPost::operator()(const std::wstring &url, const std::wstring &port, const std::wstring &request) {
+std::string HttpPost::operator()(const std::string &url, const std::string &port, const HttpRequest &request) {
 
-    const int tcpSocket = createTcpSocket();
-    if(tcpSocket == -1){
-        exit(-1);
-    }
+    HttpResponseParser response;
+    bool received = false;
+    bool closedByServer = false;
 
-    int retValue = connectTcp(url, port);
-    if(retValue == -1){
-        exit(-1);
+    // A reused connection may have been dropped by the server in the meantime, in that case retry once on a new connection
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        const bool reused = isConnectionReusable(url, port);
+        if (!reused) {
+            closeConnection();
+            int retValue = connectTcp(url, port);
+            if (retValue == -2) {           // Client is unable to connect to the server ( either client doesn't have internet, DNS failed or server is offline )
+                serverReachable = false;
+                return std::string();
+            }
+        }
+        bool staleConnection = reused;
+        if (sendHttpRequest(request) == 0) {
+            const int firstByteTimeoutMs = (request.responseTimeout.count() > 0) ? static_cast<int>(request.responseTimeout.count()) : FIRST_BYTE_TIMEOUT_MS;
+            received = (recvHttpResponse(response, firstByteTimeoutMs, closedByServer) == 0);
+            staleConnection = reused && closedByServer;
+        }
+        if (!staleConnection) {
+            break;
+        }
     }
-    else if(retValue == -2){    // Client is unable to connect to the server ( either client doesn't have internet or server is offline )
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        return std::wstring();
+    // An error status (e.g. a proxy's error page) means the server itself wasn't reached
+    const int status = received ? response.getStatusCode() : 0;
+    serverReachable = (status >= 200 && status < 300);
+    if (!serverReachable) {
+        return std::string();
     }
-
-    retValue = sendHttpRequest(request);
-    if(retValue == -1){
-        return std::wstring();
+    const std::string acceptedCodings = response.getHeader("x-accept-payload-encoding");
+    if (!acceptedCodings.empty()) {
+        serverPayloadCodings = acceptedCodings;
     }
-    std::wstring readBuffStr = recvHttpResponse();
-    if(readBuffStr.empty()){
-        return std::wstring();
+    // Undo the HTTP content coding first
+    std::string body;
+    const std::string contentEncoding = response.getHeader("content-encoding");
+    if (!Compression::decompress(Compression::fromName(contentEncoding), response.getBody(), body)) {
+        return std::string();
     }
-
-    const size_t found = readBuffStr.find(L"\r\n\r\n");
-    std::wstring decodedData;
-    if (found != std::string::npos){
-        std::string b64Data = extractBase64Data(readBuffStr.substr(found));
-        decodedData = StringUtils::s2ws(base64_decode(b64Data.c_str()));
+    std::string payload;
+    if (response.getHeader("x-transport") == "binary") {
+        serverAcceptsBinary = true;
+        std::vector<BinaryFrame> frames;
+        if (!BinaryFrame::parse(body, frames)) {
+            return std::string();
+        }
+        for (const auto &frame : frames) {                  // Server sends at most one job per reply
+            if (frame.type == BinaryFrame::Type::Job) {
+                if (!frame.decodePayload(payload)) {
+                    return std::string();
+                }
+                break;
+            }
+        }
+        return payload;
+    }
+    if (body.empty()) {
+        return std::string();
     }
-    close(tcpSocket);
-    return decodedData;
+    // Base64 transport, the decoded payload may carry its own coding
+    payload = base64_decode(body);
+    const std::string payloadEncoding = response.getHeader("x-payload-encoding");
+    if (!payloadEncoding.empty()) {
+        std::string decompressed;
+        if (!Compression::decompress(Compression::fromName(payloadEncoding), payload, decompressed)) {
+            return std::string();
+        }
+        payload.swap(decompressed);
+    }
+    return payload;
+}
+
+bool HttpPost::isServerReachable(void) const {
+    return serverReachable;
+}
+
+Compression::Coding HttpPost::getPayloadCoding(void) const {
+    return Compression::negotiate(serverPayloadCodings);
+}
+
+TransportMode HttpPost::getTransportMode(void) const {
+    return serverAcceptsBinary ? TransportMode::Binary : TransportMode::Base64;
 }
 
 HttpPost::~HttpPost(){
-    close(tcpSocket);
+    closeConnection();
 }
\ No newline at end of file
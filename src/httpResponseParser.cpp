@@ -0,0 +1,238 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "httpResponseParser.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+// Accumulate bytes up to CRLF into <line>, returns true once a complete line is available
+bool HttpResponseParser::takeLine(const char *&data, const char *end) {
+    const char *eol = static_cast<const char*>(memchr(data, '\n', end - data));
+    if (eol == nullptr) {
+        line.append(data, end - data);
+        data = end;
+        if (line.size() > MAX_LINE_LENGTH) {
+            state = State::Error;
+        }
+        return false;
+    }
+    line.append(data, eol - data);
+    data = eol + 1;
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+bool HttpResponseParser::parseStatusLine(void) {
+    // HTTP/1.1 200 OK
+    if (line.compare(0, 7, "HTTP/1.") != 0 || line.size() < 12) {
+        return false;
+    }
+    http11 = (line[7] == '1');
+    statusCode = std::atoi(line.c_str() + 9);
+    return (statusCode >= 100 && statusCode <= 999);
+}
+
+bool HttpResponseParser::parseHeaderLine(void) {
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    size_t first = line.find_first_not_of(" \t", colon + 1);
+    size_t last = line.find_last_not_of(" \t");
+    std::string value = (first == std::string::npos) ? std::string() : line.substr(first, last - first + 1);
+    headers.emplace_back(std::move(name), std::move(value));
+    return true;
+}
+
+bool HttpResponseParser::onHeadersComplete(void) {
+    if (statusCode < 200) {                                   // Interim response (e.g. 100 Continue), the real one follows
+        headers.clear();
+        state = State::StatusLine;
+        return true;
+    }
+    std::string transferEncoding = getHeader("transfer-encoding");
+    std::transform(transferEncoding.begin(), transferEncoding.end(), transferEncoding.begin(), ::tolower);
+    chunked = (transferEncoding.find("chunked") != std::string::npos);
+
+    const std::string contentLength = getHeader("content-length");
+    if (!contentLength.empty() && !chunked) {
+        char *endPtr = nullptr;
+        remaining = std::strtoull(contentLength.c_str(), &endPtr, 10);
+        if (endPtr == contentLength.c_str()) {
+            return false;
+        }
+        hasContentLength = true;
+    }
+
+    if (statusCode == 204 || statusCode == 304) {             // Never carry a body
+        state = State::Complete;
+    }
+    else if (chunked) {
+        state = State::ChunkSize;
+    }
+    else if (hasContentLength) {
+        body.reserve(std::min(remaining, MAX_BODY_RESERVE));
+        state = (remaining == 0) ? State::Complete : State::Body;
+    }
+    else {                                                    // Body is delimited by the connection close
+        state = State::UntilClose;
+    }
+    return true;
+}
+
+bool HttpResponseParser::parseChunkSize(void) {
+    char *endPtr = nullptr;
+    remaining = std::strtoull(line.c_str(), &endPtr, 16);     // Chunk extensions after ';' are ignored
+    return (endPtr != line.c_str());
+}
+
+
+// ============================ PUBLIC API ============================
+
+void HttpResponseParser::reset(void) {
+    state = State::StatusLine;
+    line.clear();
+    statusCode = 0;
+    http11 = false;
+    chunked = false;
+    hasContentLength = false;
+    remaining = 0;
+    headers.clear();
+    body.clear();
+}
+
+HttpResponseParser::Result HttpResponseParser::feed(const char *data, size_t len, size_t &consumed) {
+    const char *begin = data;
+    const char *end = data + len;
+
+    while (data < end && state != State::Complete && state != State::Error) {
+        switch (state) {
+        case State::StatusLine:
+            if (takeLine(data, end)) {
+                state = parseStatusLine() ? State::Headers : State::Error;
+                line.clear();
+            }
+            break;
+        case State::Headers:
+            if (takeLine(data, end)) {
+                bool ok = line.empty() ? onHeadersComplete() : parseHeaderLine();
+                if (!ok) { state = State::Error; }
+                line.clear();
+            }
+            break;
+        case State::Body:
+        case State::ChunkData: {
+            const size_t n = std::min(remaining, static_cast<size_t>(end - data));
+            body.append(data, n);
+            data += n;
+            remaining -= n;
+            if (remaining == 0) {
+                state = (state == State::Body) ? State::Complete : State::ChunkDataEnd;
+            }
+            break;
+        }
+        case State::ChunkDataEnd:
+            if (takeLine(data, end)) {
+                state = line.empty() ? State::ChunkSize : State::Error;
+                line.clear();
+            }
+            break;
+        case State::ChunkSize:
+            if (takeLine(data, end)) {
+                if (!parseChunkSize()) { state = State::Error; }
+                else if (remaining == 0) { state = State::Trailers; }
+                else {
+                    body.reserve(std::min(body.size() + remaining, MAX_BODY_RESERVE));
+                    state = State::ChunkData;
+                }
+                line.clear();
+            }
+            break;
+        case State::Trailers:
+            if (takeLine(data, end)) {
+                if (line.empty()) { state = State::Complete; }
+                line.clear();
+            }
+            break;
+        case State::UntilClose:
+            body.append(data, end - data);
+            data = end;
+            break;
+        default:
+            break;
+        }
+    }
+    consumed = data - begin;
+    if (state == State::Complete) { return Result::Complete; }
+    if (state == State::Error) { return Result::Error; }
+    return Result::NeedMore;
+}
+
+HttpResponseParser::Result HttpResponseParser::finish(void) {
+    if (state == State::UntilClose) {
+        state = State::Complete;
+    }
+    else if (state != State::Complete) {
+        state = State::Error;
+    }
+    return (state == State::Complete) ? Result::Complete : Result::Error;
+}
+
+bool HttpResponseParser::isComplete(void) const {
+    return state == State::Complete;
+}
+
+bool HttpResponseParser::isKeepAlive(void) const {
+    if (state != State::Complete || (!chunked && !hasContentLength && statusCode != 204 && statusCode != 304)) {
+        return false;                                         // Only a self-delimited message leaves the connection usable
+    }
+    std::string connection = getHeader("connection");
+    std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+    if (connection.find("close") != std::string::npos) {
+        return false;
+    }
+    return http11 || (connection.find("keep-alive") != std::string::npos);
+}
+
+int HttpResponseParser::getStatusCode(void) const {
+    return statusCode;
+}
+
+std::string HttpResponseParser::getHeader(const std::string &name) const {
+    for (const auto &header : headers) {
+        if (header.first == name) {
+            return header.second;
+        }
+    }
+    return std::string();
+}
+
+const std::string& HttpResponseParser::getBody(void) const {
+    return body;
+}
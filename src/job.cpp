@@ -0,0 +1,180 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "job.h"
+#include "rapidjson/reader.h"
+#include <utility>
+
+// Member names of the job and the field they are decoded into
+static const std::pair<std::string_view, std::string_view Job::*> textFields[] = {
+    {"mode",            &Job::modeName},
+    {"priority",        &Job::priority},
+    {"url",             &Job::url},
+    {"port",            &Job::port},
+    {"filePath",        &Job::filePath},
+    {"destPath",        &Job::destPath},
+    {"dirPath",         &Job::dirPath},
+    {"fileExtensions",  &Job::fileExtensions},
+    {"shellType",       &Job::shellType},
+    {"exePath",         &Job::exePath},
+    {"exeArguments",    &Job::exeArguments},
+    {"dirToList",       &Job::dirToList},
+    {"sourcePath",      &Job::sourcePath},
+    {"path",            &Job::path},
+    {"command",         &Job::command},
+    {"cd",              &Job::cd},
+    {"session",         &Job::session},
+    {"method",          &Job::method},
+    {"stream",          &Job::stream},
+    {"sha256",          &Job::sha256}
+};
+
+static const std::pair<std::string_view, uint64_t Job::*> numberFields[] = {
+    {"jobId",           &Job::id},
+    {"cancelJobId",     &Job::cancelJobId},
+    {"timeout",         &Job::timeoutSecs},
+    {"segments",        &Job::segments}
+};
+
+// SAX handler filling the top level members of a job, nested values are skipped
+class JobSaxHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JobSaxHandler> {
+
+private:
+    Job &job;
+    int depth = 0;
+    bool rootIsObject = false;
+    std::string_view Job::*textField = nullptr;
+    uint64_t Job::*numberField = nullptr;
+    bool argvKey = false;                   // The current member is "argv"
+    int argvDepth = 0;                      // Depth of the elements of the "argv" array, 0 outside of it
+
+    // A value other than a string element of "argv" (nested array, number, ...) invalidates the whole vector
+    void checkArgvValue(void) {
+        if ((argvDepth > 0 && depth >= argvDepth) || (argvKey && depth == 1)) {
+            job.argvValid = false;
+        }
+    }
+
+    bool number(uint64_t value) {
+        checkArgvValue();
+        if (depth == 1 && numberField != nullptr) {
+            job.*numberField = value;
+        }
+        return true;
+    }
+
+public:
+    explicit JobSaxHandler(Job &job) : job(job) {}
+
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        const std::string_view key(str, length);
+        textField = nullptr;
+        numberField = nullptr;
+        argvKey = false;
+        if (depth != 1) {
+            return true;
+        }
+        if (key == "argv") {
+            argvKey = true;
+            return true;
+        }
+        for (const auto &field : textFields) {
+            if (field.first == key) {
+                textField = field.second;
+                return true;
+            }
+        }
+        for (const auto &field : numberFields) {
+            if (field.first == key) {
+                numberField = field.second;
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        if (argvDepth > 0 && depth == argvDepth) {
+            job.argv.emplace_back(str, length);
+            return true;
+        }
+        checkArgvValue();
+        if (depth != 1) {
+            return true;
+        }
+        if (textField != nullptr) {
+            job.*textField = std::string_view(str, length);     // In-situ, points into the job's buffer
+        }
+        else if (numberField != nullptr) {                      // The server sends ids as strings
+            uint64_t value = 0;
+            for (const char c : std::string_view(str, length)) {
+                if (c < '0' || c > '9') {
+                    return true;
+                }
+                const uint64_t digit = static_cast<uint64_t>(c - '0');
+                value = (value > (UINT64_MAX - digit) / 10) ? UINT64_MAX : value * 10 + digit;   // Saturate, never wrap to a small value
+            }
+            job.*numberField = value;
+        }
+        return true;
+    }
+
+    bool Uint(unsigned value)       { return number(value); }
+    bool Uint64(uint64_t value)     { return number(value); }
+    bool StartObject()              { checkArgvValue(); rootIsObject |= (depth == 0); ++depth; return true; }
+    bool EndObject(rapidjson::SizeType) { --depth; return true; }
+    bool StartArray() {
+        if (argvKey && depth == 1) {
+            argvDepth = 2;
+        }
+        else {
+            checkArgvValue();
+        }
+        ++depth;
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        --depth;
+        if (depth == 1) {                   // Whatever array closed here, it was a top level member
+            argvDepth = 0;
+        }
+        return true;
+    }
+    bool Default()                  { checkArgvValue(); return true; }
+
+    bool isObject(void) const { return rootIsObject; }
+};
+
+JobPtr Job::parse(std::string json) {
+    if (json.empty()) {                                     // Heartbeat replies usually are
+        return nullptr;
+    }
+    auto job = std::make_shared<Job>();
+    job->buffer = std::move(json);                          // Parsed in place, the job is never moved afterwards
+    JobSaxHandler handler(*job);
+    rapidjson::Reader reader;
+    rapidjson::InsituStringStream stream(&job->buffer[0]);
+    if (reader.Parse<rapidjson::kParseInsituFlag | rapidjson::kParseStopWhenDoneFlag>(stream, handler).IsError() || !handler.isObject()) {
+        return nullptr;
+    }
+    return job;
+}
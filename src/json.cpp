@@ -25,37 +25,17 @@
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/error/en.h"
 #include "json.h"
-#include <codecvt>
-#include <iomanip>
-#include <locale>
-#include <iostream>         // DELETE THIS
-
-// Private Functions
-std::string JsonUtil::wstring_to_utf8(const std::wstring& wideStr) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    return converter.to_bytes(wideStr);
-}
-std::wstring JsonUtil::utf8_to_wstring(const std::string& str)
-{
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-    return myconv.from_bytes(str);
-}
-
 
 // API's
-std::wstring JsonUtil::to_json(const std::vector<std::wstring>& data) {
+std::string JsonUtil::to_json(const std::vector<std::string>& data) {
     rapidjson::Document document;
     rapidjson::Value jsonValue(rapidjson::kObjectType);
 
     if (data.size() % 2 == 0) {
         for (size_t i = 0; i < data.size(); i += 2) {
-            const std::wstring& key = data[i];
-            const std::wstring& value = data[i + 1];
-
-            rapidjson::Value utf8Key(wstring_to_utf8(key).c_str(), document.GetAllocator());
-            rapidjson::Value utf8Value(wstring_to_utf8(value).c_str(), document.GetAllocator());
-
-            jsonValue.AddMember(utf8Key.Move(), utf8Value.Move(), document.GetAllocator());
+            rapidjson::Value key(data[i].c_str(), static_cast<rapidjson::SizeType>(data[i].size()), document.GetAllocator());
+            rapidjson::Value value(data[i + 1].c_str(), static_cast<rapidjson::SizeType>(data[i + 1].size()), document.GetAllocator());
+            jsonValue.AddMember(key.Move(), value.Move(), document.GetAllocator());
         }
     }
 
@@ -63,100 +43,84 @@ std::wstring JsonUtil::to_json(const std::vector<std::wstring>& data) {
     rapidjson::StringBuffer buffer;
     rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
     jsonValue.Accept(writer);
-
-    // Convert UTF-8 encoded JSON string to std::wstring
-    return utf8_to_wstring(buffer.GetString());
+    return std::string(buffer.GetString(), buffer.GetSize());
 }
 
-std::vector<std::wstring> JsonUtil::from_json(const std::wstring& jsonData) {
-    // Convert the input jsonData (std::wstring) to UTF-8 encoded std::string
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::string utf8jsonData = converter.to_bytes(jsonData);
-
+std::vector<std::string> JsonUtil::from_json(const std::string& jsonData) {
     rapidjson::Document document;
-    document.Parse(utf8jsonData.c_str());
+    document.Parse(jsonData.c_str(), jsonData.size());
 
     if (document.HasParseError()) {
         // Handle parse error if needed
         return {};
     }
 
-    std::vector<std::wstring> parsedData;
+    std::vector<std::string> parsedData;
 
     if (document.IsObject()) {
         for (auto it = document.MemberBegin(); it != document.MemberEnd(); ++it) {
-            const std::wstring key = utf8_to_wstring(it->name.GetString());
-            const std::wstring value = utf8_to_wstring(it->value.GetString());
-
-            parsedData.push_back(key);
-            parsedData.push_back(value);
+            if (!it->value.IsString()) {
+                continue;
+            }
+            parsedData.emplace_back(it->name.GetString(), it->name.GetStringLength());
+            parsedData.emplace_back(it->value.GetString(), it->value.GetStringLength());
         }
     }
 
     return parsedData;
 }
 
-std::wstring JsonUtil::json_ExtractValue(const std::wstring& jsonData, const std::wstring& key) {
-    // Convert the input jsonData and key to UTF-8 encoded std::string
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::string utf8jsonData = converter.to_bytes(jsonData);
-    std::string utf8key = converter.to_bytes(key);
-
+std::string JsonUtil::json_ExtractValue(const std::string& jsonData, const std::string& key) {
     rapidjson::Document document;
-    document.Parse(utf8jsonData.c_str());
+    document.Parse(jsonData.c_str(), jsonData.size());
 
     if (!document.IsObject()) {
         // Handle error if needed
-        return L"";
-    }
-
-    if (!document.HasMember(utf8key.c_str())) {
-        // Handle error if needed
-        return L"";
+        return "";
     }
 
-    const rapidjson::Value& value = document[utf8key.c_str()];
-
-    if (!value.IsString()) {
+    const auto member = document.FindMember(key.c_str());
+    if (member == document.MemberEnd() || !member->value.IsString()) {
         // Handle error if needed
-        return L"";
+        return "";
     }
-
-    std::string utf8Value = value.GetString();
-    std::wstring wstringValue = utf8_to_wstring(utf8Value);
-
-    return wstringValue;
+    return std::string(member->value.GetString(), member->value.GetStringLength());
 }
 
-std::wstring JsonUtil::json_AppendKeyValue(const std::wstring& jsonData, const std::wstring& key, const std::wstring& value) {
-
-    // Convert the input jsonData, key, and value to UTF-8 encoded std::string
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::string utf8jsonData = converter.to_bytes(jsonData);
-    std::string utf8key = converter.to_bytes(key);
-    std::string utf8value = converter.to_bytes(value);      // THIS TROWS ON ls ~/Desktop/testing
-    
-    rapidjson::Document document;
-    document.Parse(utf8jsonData.c_str());
+std::string JsonUtil::json_AppendKeyValue(const std::string& jsonData, const std::string& key, const std::string& value) {
+    return json_AppendKeyValues(jsonData, {{key, value}});
+}
 
-    if (!document.IsObject()) {
+std::string JsonUtil::json_AppendKeyValues(const std::string& jsonData, const std::vector<std::pair<std::string_view, std::string_view>>& members) {
+    const size_t closingBrace = jsonData.find_last_not_of(" \t\r\n");
+    if (closingBrace == std::string::npos || jsonData[closingBrace] != '}') {
         // Handle error if needed
         return jsonData;
     }
+    const size_t lastToken = jsonData.find_last_not_of(" \t\r\n", closingBrace - 1);
+    const bool isEmpty = (lastToken != std::string::npos && jsonData[lastToken] == '{');
 
-    rapidjson::Value jsonValue(utf8value.c_str(), document.GetAllocator());
-
-    rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
-    rapidjson::Value jsonKey(utf8key.c_str(), allocator);
-    document.AddMember(jsonKey, jsonValue, allocator);
-
+    // The writer only escapes the new keys and values, the object itself is copied as is
     rapidjson::StringBuffer buffer;
     rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    document.Accept(writer);
-
-    // Convert the UTF-8 encoded JSON string to std::wstring
-    std::string utf8Result = buffer.GetString();
-    std::wstring wResult = utf8_to_wstring(utf8Result);
+    size_t reserve = closingBrace + 2;
+    for (const auto &member : members) {
+        reserve += member.first.size() + member.second.size() + 6;
+    }
+    buffer.Reserve(reserve);
+    writer.StartObject();
+    for (const auto &member : members) {
+        writer.Key(member.first.data(), static_cast<rapidjson::SizeType>(member.first.size()));
+        writer.String(member.second.data(), static_cast<rapidjson::SizeType>(member.second.size()));
+    }
+    writer.EndObject();
 
-    return wResult;
+    std::string result;
+    result.reserve(closingBrace + buffer.GetSize());
+    result.append(jsonData, 0, closingBrace);
+    if (!isEmpty && !members.empty()) {
+        result += ',';
+    }
+    result.append(buffer.GetString() + 1, buffer.GetSize() - 1);     // Members and the closing brace of the new object
+    return result;
 }
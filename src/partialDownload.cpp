@@ -0,0 +1,320 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "partialDownload.h"
+#include "sha256.h"
+#include "stringUtil.h"
+#include "base64.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cctype>
+#include <strings.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "sha-256=<base64>" from Digest or "sha-256=:<base64>:" from Repr-Digest, as hex
+static std::string sha256FromDigestHeader(const std::string &value) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (const std::string &item : StringUtils::extract_items_from_str(value, ",")) {
+        const size_t start = item.find_first_not_of(' ');
+        if (start == std::string::npos || strncasecmp(item.c_str() + start, "sha-256=", 8) != 0) {
+            continue;
+        }
+        std::string encoded = item.substr(start + 8);
+        encoded.erase(std::remove(encoded.begin(), encoded.end(), ':'), encoded.end());
+        encoded.erase(encoded.find_last_not_of(' ') + 1);
+        const std::string digest = base64_decode(encoded);
+        if (digest.size() != 32) {
+            return std::string();
+        }
+        std::string hex;
+        for (const unsigned char c : digest) {
+            hex += hexDigits[c >> 4];
+            hex += hexDigits[c & 0xF];
+        }
+        return hex;
+    }
+    return std::string();
+}
+
+// Make renames within the directory of <path> durable
+static void syncDirectoryOf(const std::string &path) {
+    const size_t slash = path.find_last_of('/');
+    const std::string dirPath = (slash == std::string::npos) ? std::string(".") : path.substr(0, slash + 1);
+    const int dirFd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+}
+
+// ============================ PUBLIC API ============================
+
+void DownloadHeaders::parse(const std::string &rawLine) {
+    std::string line = rawLine;
+    line.erase(line.find_last_not_of("\r\n") + 1);
+    if (line.compare(0, 5, "HTTP/") == 0) {             // Status line, a new response (e.g. after "100 Continue") begins
+        *this = DownloadHeaders();
+        return;
+    }
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+        return;
+    }
+    const std::string name = line.substr(0, colon);
+    const size_t valueStart = line.find_first_not_of(' ', colon + 1);
+    const std::string value = (valueStart == std::string::npos) ? std::string() : line.substr(valueStart);
+    if (strcasecmp(name.c_str(), "ETag") == 0) {
+        etag = value;
+    }
+    else if (strcasecmp(name.c_str(), "Last-Modified") == 0) {
+        lastModified = value;
+    }
+    else if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+        contentLength = std::strtoll(value.c_str(), nullptr, 10);
+    }
+    else if (strcasecmp(name.c_str(), "Content-Range") == 0) {   // "bytes <start>-<end>/<total>" or "bytes */<total>"
+        const size_t slash = value.find('/');
+        if (strncasecmp(value.c_str(), "bytes ", 6) == 0 && slash != std::string::npos) {
+            rangeStart = (value[6] == '*') ? -1 : std::strtoll(value.c_str() + 6, nullptr, 10);
+            rangeTotal = (value[slash + 1] == '*') ? -1 : std::strtoll(value.c_str() + slash + 1, nullptr, 10);
+        }
+    }
+    else if (strcasecmp(name.c_str(), "Accept-Ranges") == 0) {
+        acceptsRanges = (strcasecmp(value.c_str(), "bytes") == 0);
+    }
+    else if (strcasecmp(name.c_str(), "Retry-After") == 0) {     // Seconds, or an HTTP date
+        struct tm when {};
+        if (!value.empty() && isdigit(static_cast<unsigned char>(value[0]))) {
+            retryAfter = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S", &when) != nullptr) {
+            retryAfter = std::max<int64_t>(timegm(&when) - time(nullptr), 0);
+        }
+    }
+    else if (strcasecmp(name.c_str(), "Digest") == 0 || strcasecmp(name.c_str(), "Repr-Digest") == 0) {
+        const std::string digest = sha256FromDigestHeader(value);
+        if (!digest.empty()) {
+            sha256 = digest;
+        }
+    }
+}
+
+std::string DownloadHeaders::validator(void) const {
+    return !etag.empty() ? etag : lastModified;
+}
+
+PartialDownload::PartialDownload(const std::string &finalPath)
+    : finalPath(finalPath), partPath(finalPath + ".part"), statePath(finalPath + ".part.state") {}
+
+PartialDownload::~PartialDownload() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool PartialDownload::open(const std::string &url, int64_t &resumeOffset) {
+    resumeOffset = 0;
+    fd = ::open(partPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // The state record is "<key> <value>" per line
+    std::ifstream state(statePath);
+    std::string line;
+    std::string stateUrl;
+    while (std::getline(state, line)) {
+        const size_t space = line.find(' ');
+        const std::string key = line.substr(0, space);
+        const std::string value = (space == std::string::npos) ? std::string() : line.substr(space + 1);
+        if (key == "url") {
+            stateUrl = value;
+        }
+        else if (key == "validator") {
+            validator = value;
+        }
+        else if (key == "size") {
+            totalSize = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (key == "sha256") {
+            sha256 = value;
+        }
+        else if (key == "synced") {
+            syncedSize = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if (key == "pending") {                    // "<start>-<end>,..."
+            for (const std::string &range : StringUtils::extract_items_from_str(value, ",")) {
+                char *end = nullptr;
+                const int64_t start = std::strtoll(range.c_str(), &end, 10);
+                if (*end == '-') {
+                    pendingRanges.emplace_back(start, std::strtoll(end + 1, nullptr, 10));
+                }
+            }
+        }
+    }
+    this->url = url;
+    if (stateUrl != url) {                              // Leftover of some other download, or no state at all
+        return restart();
+    }
+    resumeOffset = size();
+    if (totalSize >= 0 && resumeOffset > totalSize) {
+        return restart();
+    }
+    if (!isSegmented() && resumeOffset > syncedSize) {
+        resumeOffset = std::max<int64_t>(syncedSize, 0);
+        if (ftruncate(fd, resumeOffset) != 0) {
+            return false;
+        }
+    }
+    if (isSegmented()) {                                // The file is preallocated, only the pending ranges tell what is missing
+        resumeOffset = totalSize;
+        for (const auto &range : pendingRanges) {
+            resumeOffset -= range.second - range.first;
+        }
+    }
+    return resumeOffset >= 0;
+}
+
+bool PartialDownload::restart(void) {
+    validator.clear();
+    totalSize = -1;
+    sha256.clear();
+    pendingRanges.clear();
+    syncedSize = 0;
+    return ftruncate(fd, 0) == 0 && saveState();
+}
+
+bool PartialDownload::isSegmented(void) const {
+    return !pendingRanges.empty();
+}
+
+bool PartialDownload::preallocate(int64_t size) {
+    if (fallocate(fd, 0, 0, size) == 0) {
+        return true;
+    }
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {       // i.e. ENOSPC
+        return false;
+    }
+    return ftruncate(fd, size) == 0;                    // The file system can't reserve space, a sparse file has to do
+}
+
+bool PartialDownload::saveState(void) {
+    // Written aside, synced and renamed, a crash leaves either the old or the new record. The data goes to
+    // disk first, so the record never claims ranges a power loss could still take away
+    const std::string tempPath = statePath + ".tmp";
+    std::ostringstream state;
+    state << "url " << url << "\n"
+          << "validator " << validator << "\n"
+          << "size " << totalSize << "\n"
+          << "sha256 " << sha256 << "\n"
+          << "synced " << syncedSize << "\n"
+          << "pending ";
+    for (size_t i = 0; i < pendingRanges.size(); ++i) {
+        state << (i > 0 ? "," : "") << pendingRanges[i].first << "-" << pendingRanges[i].second;
+    }
+    state << "\n";
+    const std::string record = state.str();
+
+    if (fsync(fd) != 0) {
+        return false;
+    }
+    const int stateFd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (stateFd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < record.size()) {
+        const ssize_t count = ::write(stateFd, record.data() + written, record.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(count);
+    }
+    const bool synced = (written == record.size()) && fsync(stateFd) == 0;
+    close(stateFd);
+    if (!synced || std::rename(tempPath.c_str(), statePath.c_str()) != 0) {
+        return false;
+    }
+    syncDirectoryOf(statePath);
+    return true;
+}
+
+bool PartialDownload::write(int64_t offset, const char *data, size_t len) {
+    while (len > 0) {
+        const ssize_t written = pwrite(fd, data, len, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        len -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+int64_t PartialDownload::size(void) const {
+    struct stat info;
+    return (fstat(fd, &info) == 0) ? info.st_size : -1;
+}
+
+std::string PartialDownload::computeSha256(void) const {
+    Sha256 hash;
+    std::vector<char> buffer(256 * 1024);
+    int64_t offset = 0;
+    ssize_t count;
+    while ((count = pread(fd, buffer.data(), buffer.size(), offset)) != 0) {
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::string();
+        }
+        hash.update(buffer.data(), static_cast<size_t>(count));
+        offset += count;
+    }
+    return hash.hexDigest();
+}
+
+bool PartialDownload::finalize(void) {
+    if (fsync(fd) != 0 || std::rename(partPath.c_str(), finalPath.c_str()) != 0) {
+        return false;
+    }
+    syncDirectoryOf(finalPath);                         // Make the rename itself durable before the state record goes
+    unlink(statePath.c_str());
+    return true;
+}
+
+void PartialDownload::discard(void) {
+    unlink(partPath.c_str());
+    unlink(statePath.c_str());
+}
@@ -0,0 +1,114 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "pollScheduler.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+void PollScheduler::armTimer(std::chrono::milliseconds interval) {
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = interval.count() / 1000;
+    spec.it_value.tv_nsec = (interval.count() % 1000) * 1000000;
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;                  // A zero value would disarm the timer
+    }
+    if (timerfd_settime(timerFd, 0, &spec, nullptr) == -1) {
+        perror("timerfd_settime");
+    }
+}
+
+
+// ============================ PUBLIC API ============================
+
+PollScheduler::PollScheduler(std::chrono::milliseconds heartbeat, std::chrono::milliseconds maxIdle, std::chrono::milliseconds active)
+    : heartbeatInterval(heartbeat), maxIdleInterval(maxIdle), activeInterval(active), nextInterval(active) {
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd == -1 || timerFd == -1 || wakeFd == -1) {
+        perror("PollScheduler");
+        exit(-1);
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+PollScheduler::~PollScheduler() {
+    close(wakeFd);
+    close(timerFd);
+    close(epollFd);
+}
+
+void PollScheduler::onActivity(void) {
+    nextInterval = activeInterval;
+}
+
+void PollScheduler::onIdle(void) {
+    if (nextInterval < heartbeatInterval) {
+        nextInterval = heartbeatInterval;           // Just became idle
+    }
+    else {
+        nextInterval = std::min(nextInterval * 2, maxIdleInterval);
+    }
+}
+
+void PollScheduler::wake(void) {
+    const uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+void PollScheduler::waitForNextPoll(void) {
+    armTimer(nextInterval);
+    struct epoll_event events[2];
+    const int n = epoll_wait(epollFd, events, 2, -1);
+    if (n == -1 && errno == EINTR) {                // Interrupted by a signal, let the caller look at its state
+        return;
+    }
+    if (n == -1) {                                  // Never spin, even if epoll is broken
+        perror("epoll_wait");
+        std::this_thread::sleep_for(nextInterval);
+        return;
+    }
+    for (int i = 0; i < n; ++i) {                   // Drain whatever fired so the next wait blocks again
+        uint64_t value;
+        if (read(events[i].data.fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+            perror("read");
+        }
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "resolverCache.h"
+#include <netdb.h>
+#include <cstring>
+#include <condition_variable>
+#include <thread>
+
+struct ResolverCache::PendingLookup {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+    std::vector<ResolvedAddress> addresses;
+};
+
+std::shared_ptr<ResolverCache::State> ResolverCache::state = std::make_shared<ResolverCache::State>();
+constexpr std::chrono::seconds ResolverCache::TTL;
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+std::vector<ResolvedAddress> ResolverCache::lookup(const std::string &host, const std::string &port) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+    struct addrinfo *result = nullptr;
+    std::vector<ResolvedAddress> ipv6, ipv4;
+
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        return {};
+    }
+    const bool ipv6First = (result->ai_family == AF_INET6);    // Keep the family getaddrinfo() preferred (RFC 6724) in front
+    for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        ResolvedAddress resolved;
+        std::memcpy(&resolved.address, ai->ai_addr, ai->ai_addrlen);
+        resolved.length = ai->ai_addrlen;
+        resolved.family = ai->ai_family;
+        (ai->ai_family == AF_INET6 ? ipv6 : ipv4).push_back(resolved);
+    }
+    freeaddrinfo(result);
+
+    // Alternate the families so a broken one only delays the connection by one attempt
+    std::vector<ResolvedAddress> ordered;
+    std::vector<ResolvedAddress> &first = ipv6First ? ipv6 : ipv4;
+    std::vector<ResolvedAddress> &second = ipv6First ? ipv4 : ipv6;
+    for (size_t i = 0; i < first.size() || i < second.size(); ++i) {
+        if (i < first.size()) { ordered.push_back(first[i]); }
+        if (i < second.size()) { ordered.push_back(second[i]); }
+    }
+    return ordered;
+}
+
+
+// ============================ PUBLIC API ============================
+
+bool ResolverCache::resolve(const std::string &host, const std::string &port, std::chrono::milliseconds timeout, std::vector<ResolvedAddress> &addresses) {
+    const std::string key = host + ":" + port;
+    const std::shared_ptr<State> shared = state;
+    std::shared_ptr<PendingLookup> pending;
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        auto it = shared->cache.find(key);
+        if (it != shared->cache.end() && std::chrono::steady_clock::now() < it->second.expiresAt) {
+            addresses = it->second.addresses;
+            return true;
+        }
+        auto inFlight = shared->pendingLookups.find(key);
+        if (inFlight != shared->pendingLookups.end()) {             // Join the lookup somebody else started
+            pending = inFlight->second;
+        }
+        else {
+            pending = std::make_shared<PendingLookup>();
+            shared->pendingLookups[key] = pending;
+            // getaddrinfo() can't be timed out, so it runs detached and fills the cache whenever it completes.
+            // It holds its own reference to the state, which thus outlives the static one at exit
+            std::thread([shared, pending, key, host, port]() {
+                std::vector<ResolvedAddress> result = lookup(host, port);
+                {
+                    std::lock_guard<std::mutex> lock(shared->mutex);
+                    if (!result.empty()) {
+                        shared->cache[key] = Entry{result, std::chrono::steady_clock::now() + TTL};
+                    }
+                    shared->pendingLookups.erase(key);
+                }
+                std::lock_guard<std::mutex> lock(pending->mutex);
+                pending->addresses = std::move(result);
+                pending->finished = true;
+                pending->done.notify_all();
+            }).detach();
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(pending->mutex);
+        pending->done.wait_for(lock, timeout, [&pending]() { return pending->finished; });
+        if (pending->finished && !pending->addresses.empty()) {
+            addresses = pending->addresses;
+            return true;
+        }
+    }
+    // Resolver failed or is slow, an expired entry is better than nothing
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    auto it = shared->cache.find(key);
+    if (it != shared->cache.end()) {
+        addresses = it->second.addresses;
+        return true;
+    }
+    return false;
+}
+
+void ResolverCache::invalidate(const std::string &host, const std::string &port) {
+    const std::shared_ptr<State> shared = state;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->cache.erase(host + ":" + port);
+}
@@ -0,0 +1,308 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "segmentedDownload.h"
+#include "transferEngine.h"
+#include <algorithm>
+
+struct SegmentedDownload::Transfer {
+    SegmentedDownload *owner = nullptr;
+    TransferHandle handle;
+    Segment segment;
+    int64_t firstByte = 0;                              // segment.next when the request started
+    std::string range;                                  // Kept alive for CURLOPT_RANGE
+    DownloadHeaders headers;
+    bool checked = false;                               // The response was verified to continue the part file
+    bool changed = false;                               // Its Content-Range or validator doesn't match the part file
+    bool writeFailed = false;
+};
+
+constexpr int64_t SegmentedDownload::MIN_SEGMENT_SIZE;
+constexpr size_t SegmentedDownload::MAX_CONNECTIONS;
+constexpr int SegmentedDownload::MAX_FAILURES;
+constexpr int64_t SegmentedDownload::MAX_RETRY_AFTER_SECS;
+
+static const long POLL_INTERVAL_MS = 200;               // Upper bound of a wait, so a stopped job is noticed
+static const std::chrono::seconds SAVE_INTERVAL {1};    // Progress lost when the client dies
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+size_t SegmentedDownload::writeSegment(void *buffer, size_t size, size_t nmemb, void *userp) {
+    Transfer *transfer = static_cast<Transfer*>(userp);
+    PartialDownload &part = transfer->owner->part;
+    const size_t len = size * nmemb;
+    long status = 0;
+    curl_easy_getinfo(transfer->handle.get(), CURLINFO_RESPONSE_CODE, &status);
+    if (status != 206) {
+        return (status == 200) ? 0 : len;               // The whole file is useless here, an error page is discarded
+    }
+    if (!transfer->checked) {
+        const std::string validator = transfer->headers.validator();
+        if (transfer->headers.rangeStart != transfer->segment.next || transfer->headers.rangeTotal != part.totalSize ||
+            (!part.validator.empty() && !validator.empty() && validator != part.validator)) {
+            transfer->changed = true;
+            return 0;
+        }
+        transfer->checked = true;
+    }
+    const size_t wanted = static_cast<size_t>(std::min<int64_t>(len, transfer->segment.end - transfer->segment.next));
+    if (wanted > 0 && !part.write(transfer->segment.next, static_cast<const char*>(buffer), wanted)) {
+        transfer->writeFailed = true;
+        return 0;
+    }
+    transfer->segment.next += static_cast<int64_t>(wanted);
+    return (wanted < len) ? 0 : len;                    // The rest belongs to a range split off meanwhile, stop here
+}
+
+size_t SegmentedDownload::readHeader(char *buffer, size_t size, size_t nitems, void *userp) {
+    static_cast<Transfer*>(userp)->headers.parse(std::string(buffer, size * nitems));
+    return size * nitems;
+}
+
+bool SegmentedDownload::takeWork(Segment &segment) {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+        if (it->notBefore <= now) {
+            segment = *it;
+            idle.erase(std::next(it).base());
+            return true;
+        }
+    }
+    // Nothing ready to hand out, split the largest range in flight
+    Transfer *largest = nullptr;
+    for (auto &transfer : transfers) {
+        if (largest == nullptr || transfer->segment.end - transfer->segment.next > largest->segment.end - largest->segment.next) {
+            largest = transfer.get();
+        }
+    }
+    if (largest == nullptr || largest->segment.end - largest->segment.next < 2 * MIN_SEGMENT_SIZE) {
+        return false;
+    }
+    const int64_t middle = largest->segment.next + (largest->segment.end - largest->segment.next) / 2;
+    segment = {middle, largest->segment.end};
+    largest->segment.end = middle;
+    return true;
+}
+
+bool SegmentedDownload::start(const Segment &segment) {
+    std::unique_ptr<Transfer> transfer(new Transfer);
+    transfer->owner = this;
+    transfer->segment = segment;
+    transfer->firstByte = segment.next;
+    if (!transfer->handle) {
+        idle.push_back(segment);
+        return false;
+    }
+    transfer->range = std::to_string(segment.next) + "-" + std::to_string(segment.end - 1);
+    CURL *curl = transfer->handle.get();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_RANGE, transfer->range.c_str());
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, readHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer.get());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeSegment);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);        // A connection silent for a minute gives its range back
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+    curl_multi_add_handle(multi, curl);
+    transfers.push_back(std::move(transfer));
+    return true;
+}
+
+void SegmentedDownload::saveProgress(void) {
+    part.pendingRanges.clear();
+    for (const Segment &segment : idle) {
+        part.pendingRanges.emplace_back(segment.next, segment.end);
+    }
+    for (const auto &transfer : transfers) {
+        if (transfer->segment.next < transfer->segment.end) {
+            part.pendingRanges.emplace_back(transfer->segment.next, transfer->segment.end);
+        }
+    }
+    std::sort(part.pendingRanges.begin(), part.pendingRanges.end());
+    // Once nothing is pending the file counts as a complete single stream download, which must not be cut back
+    part.syncedSize = part.pendingRanges.empty() ? part.totalSize : part.pendingRanges.front().first;
+    part.saveState();
+    savedAt = std::chrono::steady_clock::now();
+}
+
+void SegmentedDownload::stopTransfers(void) {
+    for (auto &transfer : transfers) {
+        if (transfer->segment.next < transfer->segment.end) {
+            idle.push_back(transfer->segment);
+        }
+        curl_multi_remove_handle(multi, transfer->handle.get());
+    }
+    transfers.clear();
+}
+
+
+// ============================ PUBLIC API ============================
+
+SegmentedDownload::SegmentedDownload(const std::string &url, PartialDownload &part, size_t connections, CancelToken *token)
+    : url(url), part(part), connections(std::min(std::max<size_t>(connections, 1), MAX_CONNECTIONS)), token(token), multi(curl_multi_init()) {
+    if (multi != nullptr) {
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(this->connections));
+    }
+}
+
+SegmentedDownload::~SegmentedDownload() {
+    stopTransfers();
+    if (multi != nullptr) {
+        curl_multi_cleanup(multi);
+    }
+}
+
+SegmentedDownload::Result SegmentedDownload::run(std::string &errorMsg) {
+    if (multi == nullptr) {
+        errorMsg = "Failed to initialize libcurl";
+        return Result::Failed;
+    }
+    idle.clear();
+    for (const auto &range : part.pendingRanges) {
+        if (range.first < range.second) {
+            idle.push_back({range.first, range.second});
+        }
+    }
+    // Cut the missing ranges into one piece per connection up front, so no request has to be cut short later
+    while (idle.size() < connections) {
+        const auto largest = std::max_element(idle.begin(), idle.end(), [](const Segment &a, const Segment &b) { return a.end - a.next < b.end - b.next; });
+        if (largest == idle.end() || largest->end - largest->next < 2 * MIN_SEGMENT_SIZE) {
+            break;
+        }
+        const Segment upperHalf {largest->next + (largest->end - largest->next) / 2, largest->end};
+        largest->end = upperHalf.next;
+        idle.push_back(upperHalf);
+    }
+    savedAt = std::chrono::steady_clock::now();
+
+    Result result = Result::Complete;
+    bool finished = false;
+    bool restart = false;
+    int failures = 0;
+    while (!finished) {
+        if (token != nullptr && token->isStopped()) {
+            errorMsg = "job " + token->stopReason();
+            result = Result::Retry;
+            break;
+        }
+        Segment segment;
+        bool startFailed = false;
+        while (transfers.size() < connections && takeWork(segment)) {
+            if (!start(segment)) {
+                startFailed = true;
+                break;
+            }
+        }
+        if (transfers.empty() && (startFailed || idle.empty())) {
+            if (startFailed) {
+                errorMsg = "Failed to initialize libcurl";
+                result = Result::Failed;
+            }
+            break;
+        }                                               // Otherwise every missing range is backing off
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int pending = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &pending)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *curl = message->easy_handle;
+            const CURLcode code = message->data.result;     // <message> is gone once the handle is removed
+            curl_multi_remove_handle(multi, curl);
+            const auto it = std::find_if(transfers.begin(), transfers.end(), [curl](const std::unique_ptr<Transfer> &transfer) { return transfer->handle.get() == curl; });
+            if (it == transfers.end()) {
+                continue;
+            }
+            const Transfer &transfer = **it;
+            long status = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+            if (transfer.segment.next > transfer.firstByte) {
+                failures = 0;                           // Only a range that got somewhere counts as success
+            }
+            if (transfer.segment.next >= transfer.segment.end) {
+                // Done, maybe cut short because its range was split
+            }
+            else if (transfer.writeFailed) {
+                errorMsg = "Couldn't write the part file";
+                result = Result::Failed;
+                finished = true;
+            }
+            else if (transfer.changed) {
+                errorMsg = "file changed on the server";
+                result = Result::Retry;
+                restart = true;
+                finished = true;
+            }
+            else if (status == 200) {
+                result = Result::RangesUnsupported;
+                finished = true;
+            }
+            else if (status >= 400 && status < 500 && status != 408 && status != 429) {
+                errorMsg = "HTTP " + std::to_string(status);
+                result = Result::Failed;
+                finished = true;
+            }
+            else {
+                if (status == 429 || status == 503) {   // The server limits connections, make do with fewer
+                    connections = std::max<size_t>(connections - 1, 1);
+                }
+                errorMsg = (code != CURLE_OK) ? curl_easy_strerror(code) : (status >= 400) ? "HTTP " + std::to_string(status) : "connection closed early";
+                // Back off as the server asks, or 1, 2, 4 ... seconds, then someone else continues where it stopped
+                const int64_t delaySecs = (transfer.headers.retryAfter >= 0) ? std::min(transfer.headers.retryAfter, MAX_RETRY_AFTER_SECS)
+                                                                             : (int64_t(1) << std::min(failures, 4));
+                Segment retry = transfer.segment;
+                retry.notBefore = std::chrono::steady_clock::now() + std::chrono::seconds(delaySecs);
+                idle.push_back(retry);
+                ++failures;
+            }
+            transfers.erase(it);
+        }
+        if (failures >= MAX_FAILURES) {
+            result = Result::Retry;
+            break;
+        }
+        if (!finished && std::chrono::steady_clock::now() - savedAt >= SAVE_INTERVAL) {
+            saveProgress();
+        }
+        if (!finished) {
+            // Wake up for the next range whose back-off ends, too
+            const auto now = std::chrono::steady_clock::now();
+            long waitMs = POLL_INTERVAL_MS;
+            for (const Segment &waiting : idle) {
+                if (waiting.notBefore > now) {
+                    waitMs = std::min<long>(waitMs, std::chrono::duration_cast<std::chrono::milliseconds>(waiting.notBefore - now).count() + 1);
+                }
+            }
+            curl_multi_poll(multi, nullptr, 0, static_cast<int>(waitMs), nullptr);
+        }
+    }
+    stopTransfers();
+    if (restart) {
+        part.restart();
+    }
+    else if (result != Result::RangesUnsupported) {
+        saveProgress();
+    }
+    return result;
+}
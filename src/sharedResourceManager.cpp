@@ -21,51 +21,116 @@
 
 #include "sharedResourceManager.h"
 
-void SharedResourceManager::pushResponse(const std::wstring &response) {
-	std::lock_guard<std::mutex> lock(responseQueueMutex);
-	if (! (response.empty()) ) {
-		responseQueue.push(response);
+void SharedResourceManager::pushResponse(JobResponse response) {
+	std::function<void()> listener;
+	{
+		std::lock_guard<std::mutex> lock(responseQueueMutex);
+		if (response.json.empty()) {
+			return;
+		}
+		queuedBytes += response.json.size();
+		responseQueues[laneIndex(response.priority)].push(std::move(response));
+		listener = responseListener;				// A copy, so it may be replaced while it runs
+	}
+	if (listener) {
+		listener();
 	}
 }
 
-std::wstring SharedResourceManager::popResponse(void) {
+std::vector<JobResponse> SharedResourceManager::popResponses(size_t maxCount, size_t maxBytes) {
 	std::lock_guard<std::mutex> lock(responseQueueMutex);
-	std::wstring response;
-	if(! (responseQueue.empty()) ){
-		response = responseQueue.front();
-		responseQueue.pop();
+	std::vector<JobResponse> responses;
+	size_t totalBytes = 0;
+	for (auto &responseQueue : responseQueues) {
+		while (!responseQueue.empty() && responses.size() < maxCount) {
+			const size_t size = responseQueue.front().json.size();
+			if (!responses.empty() && totalBytes + size > maxBytes) {
+				break;				// Don't let a smaller, lower priority response overtake this one
+			}
+			totalBytes += size;
+			responses.push_back(std::move(responseQueue.front()));
+			responseQueue.pop();
+		}
+		if (!responseQueue.empty()) {
+			break;
+		}
 	}
-	return response;
+	queuedBytes -= totalBytes;
+	responseQueueDrained.notify_all();
+	return responses;
 }
 
-void SharedResourceManager::pushJob(const std::wstring &job) {
-	std::lock_guard<std::mutex> lock(jobQueueMutex);
-	if (! (job.empty()) ) {
-		jobQueue.push(job);
+bool SharedResourceManager::waitForResponseSpace(const CancelToken &token) {
+	std::unique_lock<std::mutex> lock(responseQueueMutex);
+	while (queuedBytes >= responseQueueLimit) {
+		if (token.isStopped()) {
+			return false;
+		}
+		responseQueueDrained.wait_for(lock, std::chrono::milliseconds(100));	// Woken by the sender, the timeout only notices cancellation
 	}
+	return !token.isStopped();
 }
 
-std::wstring SharedResourceManager::popJob(void) {
-	std::lock_guard<std::mutex> lock(jobQueueMutex);
-	std::wstring job;
-	if ( !(jobQueue.empty()) ) {
-		job = jobQueue.front();
-		jobQueue.pop();
-	}
-	return job;
+void SharedResourceManager::setResponseQueueLimit(size_t bytes) {
+	std::lock_guard<std::mutex> lock(responseQueueMutex);
+	responseQueueLimit = bytes;
+}
+
+void SharedResourceManager::setOutputMemoryLimit(size_t bytes) {
+	outputMemoryLimit = bytes;
 }
 
-void SharedResourceManager::setSysInfoInJson(const std::wstring &sysInfo) {
+size_t SharedResourceManager::getOutputMemoryLimit(void) {
+	return outputMemoryLimit;
+}
+
+void SharedResourceManager::setSysInfoInJson(const std::string &sysInfo) {
 	std::lock_guard<std::mutex> lock(jsonSysInfoMutex);
 	jsonSysInfo = sysInfo;
 }
 
-std::wstring SharedResourceManager::getSysInfoInJson(void) {
+std::string SharedResourceManager::getSysInfoInJson(void) {
 	std::lock_guard<std::mutex> lock(jsonSysInfoMutex);
 	return jsonSysInfo;
 }
 
 bool SharedResourceManager::isResponseAvailable(void) {	
 	std::lock_guard<std::mutex> lock(responseQueueMutex);
-	return !responseQueue.empty();
-}
\ No newline at end of file
+	for (const auto &responseQueue : responseQueues) {
+		if (!responseQueue.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void SharedResourceManager::setResponseListener(std::function<void()> listener) {
+	std::lock_guard<std::mutex> lock(responseQueueMutex);
+	responseListener = std::move(listener);
+}
+bool SharedResourceManager::registerJob(uint64_t jobId, CancelTokenPtr token) {
+	std::lock_guard<std::mutex> lock(activeJobsMutex);
+	return activeJobs.emplace(jobId, std::move(token)).second;
+}
+
+void SharedResourceManager::unregisterJob(uint64_t jobId) {
+	std::lock_guard<std::mutex> lock(activeJobsMutex);
+	activeJobs.erase(jobId);
+}
+
+CancelTokenPtr SharedResourceManager::findJob(uint64_t jobId) {
+	std::lock_guard<std::mutex> lock(activeJobsMutex);
+	const auto it = activeJobs.find(jobId);
+	return (it == activeJobs.end()) ? nullptr : it->second;
+}
+
+void SharedResourceManager::cancelAllJobs(void) {
+	std::lock_guard<std::mutex> lock(activeJobsMutex);
+	for (auto &job : activeJobs) {
+		job.second->cancel();
+	}
+}
+
+ShellSessions& SharedResourceManager::getShellSessions(void) {
+	return shellSessions;
+}
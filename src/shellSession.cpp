@@ -0,0 +1,305 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "shellSession.h"
+#include "stringUtil.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <csignal>
+#include <cstring>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <random>
+#include <algorithm>
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+void ShellSession::terminate(void) {
+    if (shellPid > 0) {
+        kill(-shellPid, SIGKILL);           // The shell and every command it started share its process group
+        while (waitpid(shellPid, nullptr, 0) == -1 && errno == EINTR) {
+        }
+        shellPid = -1;
+    }
+    if (commandPipe != -1) {
+        close(commandPipe);
+        commandPipe = -1;
+    }
+    if (ptyMaster != -1) {
+        close(ptyMaster);
+        ptyMaster = -1;
+    }
+    alive = false;
+}
+
+// Ends the output of one command, random so no command prints it by accident
+static std::string randomMarker(void) {
+    std::random_device random;
+    static const char hex[] = "0123456789abcdef";
+    std::string marker {"__CLIENTHTTP_DONE_"};
+    for (int i = 0; i < 16; ++i) {
+        marker += hex[random() % 16];
+    }
+    return marker + "__";
+}
+
+static bool writeAll(int fd, const std::string &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+
+// ============================ PUBLIC API ============================
+
+std::string ShellSession::quote(const std::string &text) {
+    std::string quoted {"'"};
+    for (const char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";                  // The quote itself becomes '\''
+        }
+        else {
+            quoted += c;
+        }
+    }
+    quoted += '\'';
+    return quoted;
+}
+
+ShellSession::~ShellSession() {
+    terminate();
+}
+
+bool ShellSession::start(const std::string &shell, const std::string &workingDir, std::string &error) {
+    ptyMaster = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    char slaveName[128];
+    if (ptyMaster == -1 || grantpt(ptyMaster) != 0 || unlockpt(ptyMaster) != 0 || ptsname_r(ptyMaster, slaveName, sizeof(slaveName)) != 0) {
+        error = std::string("pty: ") + strerror(errno);
+        terminate();
+        return false;
+    }
+    // Raw output, "\n" stays "\n"
+    const int slave = open(slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave == -1) {
+        error = std::string("pty: ") + strerror(errno);
+        terminate();
+        return false;
+    }
+    struct termios settings;
+    if (tcgetattr(slave, &settings) == 0) {
+        settings.c_oflag &= ~OPOST;
+        settings.c_lflag &= ~ECHO;
+        tcsetattr(slave, TCSANOW, &settings);
+    }
+    struct winsize size = {};
+    size.ws_row = 24;
+    size.ws_col = 120;
+    ioctl(slave, TIOCSWINSZ, &size);
+
+    // The shell reads commands from a pipe, so it isn't interactive: no prompt, no line editing
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC) == -1) {
+        error = std::string("pipe: ") + strerror(errno);
+        close(slave);
+        terminate();
+        return false;
+    }
+    commandPipe = pipefd[1];
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipefd[0], STDIN_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, slaveName, O_RDWR, 0);   // Opened after setsid(), becomes the controlling terminal
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    std::string shellArg0 = shell;
+    char *argv[] = {&shellArg0[0], nullptr};
+    extern char** environ;
+    const int result = posix_spawn(&shellPid, shell.c_str(), &actions, &attributes, argv, environ);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipefd[0]);
+    close(slave);
+    if (result != 0) {
+        shellPid = -1;
+        error = shell + ": " + strerror(result);
+        terminate();
+        return false;
+    }
+    alive = true;
+    marker = randomMarker();
+    lastUsed = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (!workingDir.empty()) {
+        int status = 0;
+        CancelToken token(CancelToken::Clock::now() + std::chrono::milliseconds(START_TIMEOUT_MS));
+        run("cd -- " + quote(workingDir), &token, nullptr, status);
+        if (!alive) {                       // A stalled shell is killed once the token expires
+            error = shell + ": didn't start within " + std::to_string(START_TIMEOUT_MS) + " ms";
+        }
+    }
+    return alive;
+}
+
+std::string ShellSession::run(const std::string &command, CancelToken *token, const executeCommand::OutputSink &sink, int &exitStatus) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    exitStatus = -1;
+    lastUsed = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (!alive) {
+        return std::string();
+    }
+    // "command eval" keeps syntax errors from ending the shell, stdin is /dev/null so the command can't eat what follows
+    const std::string script = "command eval " + quote(command) + " </dev/null\nprintf '\\n%s %d\\n' '" + marker + "' \"$?\"\n";
+    if (!writeAll(commandPipe, script)) {
+        terminate();
+        return std::string();
+    }
+
+    std::string output;                     // Read but not handed to the sink yet, the marker line included
+    auto lastFlush = std::chrono::steady_clock::now();
+    const std::string markerStart = "\n" + marker + " ";
+    char buffer[4096];
+    while (true) {
+        const size_t markerPos = output.find(markerStart);
+        if (markerPos != std::string::npos && output.find('\n', markerPos + markerStart.size()) != std::string::npos) {
+            exitStatus = std::atoi(output.c_str() + markerPos + markerStart.size());
+            output.resize(markerPos);
+            break;
+        }
+        if (token != nullptr && token->isStopped()) {
+            terminate();                    // No job control in the shell, its commands can only be stopped with it
+            break;
+        }
+        if (sink) {                         // Hand over what can't be part of the marker line
+            const size_t safe = (output.size() > markerStart.size() + 24) ? output.size() - markerStart.size() - 24 : 0;
+            const auto now = std::chrono::steady_clock::now();
+            if (safe > 0 && (safe >= executeCommand::STREAM_CHUNK_SIZE || now - lastFlush >= std::chrono::milliseconds(executeCommand::STREAM_FLUSH_MS))) {
+                const size_t length = StringUtils::utf8CompleteLength(output.substr(0, safe));
+                if (length > 0) {
+                    sink(output.substr(0, length));
+                    output.erase(0, length);    // Only the unsent part is kept, however much the command prints
+                }
+                lastFlush = now;
+            }
+        }
+        struct pollfd pfd = {ptyMaster, POLLIN, 0};
+        const int timeoutMs = (token != nullptr) ? std::min(token->remainingMs(100), 100) : (sink ? executeCommand::STREAM_FLUSH_MS : -1);
+        const int ready = poll(&pfd, 1, timeoutMs);
+        if (ready == 0 || (ready == -1 && errno == EINTR)) {
+            continue;
+        }
+        const ssize_t bytesRead = (ready > 0) ? read(ptyMaster, buffer, sizeof(buffer)) : -1;
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {               // EIO once the shell and its children are gone, i.e. after "exit"
+            terminate();
+            break;
+        }
+        output.append(buffer, static_cast<size_t>(bytesRead));
+    }
+    lastUsed = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (sink) {
+        if (!output.empty()) {
+            sink(output);
+        }
+        return std::string();
+    }
+    return output;
+}
+
+bool ShellSession::isAlive(void) const {
+    return alive;
+}
+
+std::chrono::steady_clock::time_point ShellSession::getLastUsed(void) const {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(lastUsed.load()));
+}
+
+std::shared_ptr<ShellSession> ShellSessions::acquire(const std::string &id, std::string &error) {
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(id);
+        if (it != sessions.end() && it->second->isAlive()) {
+            return it->second;
+        }
+    }
+    // Started without the lock, a slow shell mustn't hold up the other sessions
+    auto session = std::make_shared<ShellSession>();
+    char *cwd = getcwd(nullptr, 0);
+    const std::string workingDir = (cwd != nullptr) ? cwd : "";
+    free(cwd);
+    if (!session->start("/bin/sh", workingDir, error)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = sessions.find(id);
+    if (it != sessions.end() && it->second->isAlive()) {
+        return it->second;                  // Another job started it meanwhile, ours is dropped
+    }
+    if (it != sessions.end()) {             // Ended (i.e. "exit" or cancelled), start over
+        sessions.erase(it);
+    }
+    if (sessions.size() >= MAX_SESSIONS) {
+        // Only the map holds an idle session, and callers only get one from the map under the lock,
+        // so a session picked here can't be handed out before it's erased
+        auto oldest = sessions.end();
+        for (auto candidate = sessions.begin(); candidate != sessions.end(); ++candidate) {
+            if (candidate->second.use_count() == 1 && (oldest == sessions.end() || candidate->second->getLastUsed() < oldest->second->getLastUsed())) {
+                oldest = candidate;
+            }
+        }
+        if (oldest == sessions.end()) {
+            error = "all " + std::to_string(MAX_SESSIONS) + " shell sessions are busy";
+            return nullptr;
+        }
+        sessions.erase(oldest);
+    }
+    sessions[id] = session;
+    return session;
+}
+
+void ShellSessions::closeAll(void) {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    sessions.clear();
+}
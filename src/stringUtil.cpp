@@ -20,24 +20,27 @@
 
 
 #include "stringUtil.h"
-#include <codecvt>
-#include <locale>
 
-std::wstring StringUtils::s2ws(const std::string& str) {
-    using convert_typeX = std::codecvt_utf8<wchar_t>;
-    std::wstring_convert<convert_typeX, wchar_t> converterX;
-    return converterX.from_bytes(str);
-}
-
-std::string StringUtils::ws2s(const std::wstring& wstr) {
-    using convert_typeX = std::codecvt_utf8<wchar_t>;
-    std::wstring_convert<convert_typeX, wchar_t> converterX;
-    return converterX.to_bytes(wstr);
-}
-
-std::string StringUtils::convertWStringToUTF8(const std::wstring& wstr) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> utf8_converter;
-    return utf8_converter.to_bytes(wstr);
+// Length of the valid UTF-8 sequence at <pos>, 0 if there is none
+static size_t utf8SequenceLength(std::string_view str, size_t pos) {
+    const unsigned char lead = static_cast<unsigned char>(str[pos]);
+    size_t length = 0;
+    unsigned char min = 0x80, max = 0xBF;       // Range of the second byte, excludes overlong forms and surrogates
+    if (lead < 0x80) { return 1; }
+    else if (lead >= 0xC2 && lead <= 0xDF) { length = 2; }
+    else if (lead >= 0xE0 && lead <= 0xEF) { length = 3; min = (lead == 0xE0) ? 0xA0 : 0x80; max = (lead == 0xED) ? 0x9F : 0xBF; }
+    else if (lead >= 0xF0 && lead <= 0xF4) { length = 4; min = (lead == 0xF0) ? 0x90 : 0x80; max = (lead == 0xF4) ? 0x8F : 0xBF; }
+    else { return 0; }
+    if (pos + length > str.size()) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(str[pos + i]);
+        if (c < ((i == 1) ? min : 0x80) || c > ((i == 1) ? max : 0xBF)) {
+            return 0;
+        }
+    }
+    return length;
 }
 
 std::vector<std::string> StringUtils::extract_items_from_str(const std::string &input_str, const std::string &delimiter) {
@@ -56,20 +59,56 @@ std::vector<std::string> StringUtils::extract_items_from_str(const std::string &
     return items;
 }
 
-std::string StringUtils::wstring_to_utf8(const std::wstring& wideStr) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    return converter.to_bytes(wideStr);
+std::string StringUtils::extractFilename(const std::string& filePath) {
+    size_t lastSlash = filePath.find_last_of("/\\"); // Find the last slash or backslash
+    if (lastSlash != std::string::npos) {
+        return filePath.substr(lastSlash + 1); // Extract the filename part
+    }
+    return filePath; // If no slashes or backslashes found, return the original path as the filename
+}
+
+size_t StringUtils::utf8CompleteLength(const std::string& str) {
+    size_t i = str.size();
+    size_t trailing = 0;
+    while (i > 0 && trailing < 4) {
+        --i;
+        ++trailing;
+        const unsigned char c = static_cast<unsigned char>(str[i]);
+        if ((c & 0xC0) == 0x80) {                   // Continuation byte, keep looking for the lead byte
+            continue;
+        }
+        size_t needed = 1;
+        if ((c & 0xE0) == 0xC0) { needed = 2; }
+        else if ((c & 0xF0) == 0xE0) { needed = 3; }
+        else if ((c & 0xF8) == 0xF0) { needed = 4; }
+        return (needed > trailing) ? i : str.size();
+    }
+    return str.size();
 }
 
-std::wstring StringUtils::utf8_to_wstring(const std::string& str){   
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-    return myconv.from_bytes(str);
+bool StringUtils::isValidUtf8(std::string_view str) {
+    for (size_t i = 0; i < str.size(); ) {
+        const size_t length = utf8SequenceLength(str, i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
 }
 
-std::wstring StringUtils::extractFilename(const std::wstring& filePath) {
-    size_t lastSlash = filePath.find_last_of(L"/\\"); // Find the last slash or backslash
-    if (lastSlash != std::wstring::npos) {
-        return filePath.substr(lastSlash + 1); // Extract the filename part
+std::string StringUtils::toValidUtf8(std::string_view str) {
+    std::string result;
+    result.reserve(str.size());
+    for (size_t i = 0; i < str.size(); ) {
+        const size_t length = utf8SequenceLength(str, i);
+        if (length == 0) {
+            result += '?';
+            ++i;
+            continue;
+        }
+        result.append(str.data() + i, length);
+        i += length;
     }
-    return filePath; // If no slashes or backslashes found, return the original path as the filename
-}
\ No newline at end of file
+    return result;
+}
@@ -21,14 +21,12 @@
 
 #include "systemInformation.h"
 #include <unistd.h>
-#include <codecvt>
 #include <random>
 #include <ctime>
 #include <sys/types.h>
 #include <pwd.h>
 #include <sys/utsname.h>
 #include <cstring>
-#include <locale>
 
 std::string SysInformation::generateRandomAlphanumeric(const int &length, const long long &seed) {
     std::string alphanumeric = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
@@ -42,51 +40,44 @@ std::string SysInformation::generateRandomAlphanumeric(const int &length, const
     return result;
 }
 
-std::wstring SysInformation::s2ws(const std::string& str) {
-    using convert_typeX = std::codecvt_utf8<wchar_t>;
-    std::wstring_convert<convert_typeX, wchar_t> converterX;
-
-    return converterX.from_bytes(str);
-}
-
-std::wstring SysInformation::getComputerName() {
+std::string SysInformation::getComputerName() {
     char computerName[250] = {};
     if (gethostname(computerName, sizeof(computerName)) != 0) {
         perror("gethostname");
-        return L""; // Handle the error accordingly, returning an empty wstring in this case
+        return ""; // Handle the error accordingly, returning an empty string in this case
     }
-    return std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(computerName);
+    return computerName;
 }
 
-std::wstring SysInformation::getUserName()
+std::string SysInformation::getUserName()
 {
   uid_t uid = geteuid();
   struct passwd *pw = getpwuid(uid);
   if (pw)
   {
-    return s2ws(pw->pw_name);
+    return pw->pw_name;
   }
   return {};
 }
 
-std::vector<std::wstring> SysInformation::getSysInfo() {
-    std::vector<std::wstring> data_vec;
-    std::wstring computerName = getComputerName(); // Use a wide string version of getComputerName
+std::vector<std::string> SysInformation::getSysInfo() {
+    std::vector<std::string> data_vec;
+    std::string computerName = getComputerName();
 
     // Generate the seed from time and computer name
     std::time_t currentTime = std::time(nullptr);
 
-    std::wstring seedString = std::to_wstring(currentTime) + computerName;
-    std::hash<std::wstring> seedHash;
+    std::string seedString = std::to_string(currentTime) + computerName;
+    std::hash<std::string> seedHash;
     long long seed = static_cast<long long>(seedHash(seedString));
 
     // Generate a random alphanumeric number
-    std::wstring randomAlphanumeric = s2ws(generateRandomAlphanumeric(RANDOM_NUMBER_LENGTH, seed)); // Use a wide string version of generateRandomAlphanumeric
+    std::string randomAlphanumeric = generateRandomAlphanumeric(RANDOM_NUMBER_LENGTH, seed);
 
-    data_vec.push_back(L"id");
+    data_vec.push_back("id");
     data_vec.push_back(randomAlphanumeric);
 
-    std::wstring username = getUserName(); // Use a wide string version of getUserName
+    std::string username = getUserName();
 
     struct utsname sysInfo;
     if (uname(&sysInfo) == 0);
@@ -94,13 +85,13 @@ std::vector<std::wstring> SysInformation::getSysInfo() {
         memset(&sysInfo, 0x00, sizeof(struct utsname));
     }
 
-    data_vec.push_back(L"username");
+    data_vec.push_back("username");
     data_vec.push_back(username);
-    data_vec.push_back(L"computerName");
+    data_vec.push_back("computerName");
     data_vec.push_back(computerName);
-    data_vec.push_back(L"OSname");
-    data_vec.push_back(s2ws(sysInfo.sysname));
-    data_vec.push_back(L"OSversion");
-    data_vec.push_back(s2ws(sysInfo.version).substr(0, 19));
+    data_vec.push_back("OSname");
+    data_vec.push_back(sysInfo.sysname);
+    data_vec.push_back("OSversion");
+    data_vec.push_back(std::string(sysInfo.version).substr(0, 19));
     return data_vec;
-}
\ No newline at end of file
+}
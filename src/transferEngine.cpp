@@ -0,0 +1,206 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "transferEngine.h"
+#include <algorithm>
+
+std::mutex TransferEngine::poolMutex;
+std::vector<CURL*> TransferEngine::idleHandles;
+CURLSH* TransferEngine::share = nullptr;
+std::mutex TransferEngine::shareLocks[CURL_LOCK_DATA_LAST];
+bool TransferEngine::initialized = false;
+size_t TransferEngine::uploadConcurrency = 4;
+RateLimiter TransferEngine::uploadLimiter;
+size_t TransferEngine::downloadSegments = 1;
+constexpr size_t TransferEngine::MAX_IDLE_HANDLES;
+constexpr size_t RateLimiter::MIN_GRANT;
+
+// ============================ RATE LIMITER ============================
+
+size_t RateLimiter::capacity(void) const {
+    return std::max(rate / 10, MIN_GRANT);
+}
+
+void RateLimiter::refill(void) {
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - refilledAt;
+    tokens = std::min(tokens + elapsed.count() * rate, static_cast<double>(capacity()));
+    refilledAt = now;
+}
+
+void RateLimiter::setRate(size_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    rate = bytesPerSecond;
+    tokens = static_cast<double>(capacity());
+    refilledAt = std::chrono::steady_clock::now();
+}
+
+bool RateLimiter::isLimited(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rate > 0;
+}
+
+size_t RateLimiter::take(size_t wanted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate == 0) {
+        return wanted;
+    }
+    refill();
+    if (tokens < static_cast<double>(std::min(wanted, MIN_GRANT))) {
+        return 0;
+    }
+    const size_t granted = std::min(wanted, static_cast<size_t>(tokens));
+    tokens -= static_cast<double>(granted);
+    return granted;
+}
+
+void RateLimiter::giveBack(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate > 0) {
+        tokens = std::min(tokens + static_cast<double>(bytes), static_cast<double>(capacity()));
+    }
+}
+
+std::chrono::milliseconds RateLimiter::waitTime(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate == 0) {
+        return std::chrono::milliseconds(0);
+    }
+    refill();
+    const double missing = static_cast<double>(MIN_GRANT) - tokens;
+    if (missing <= 0) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(static_cast<long>(missing * 1000 / rate) + 1);
+}
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+void TransferEngine::lockShare(CURL*, curl_lock_data data, curl_lock_access, void*) {
+    shareLocks[data].lock();
+}
+
+void TransferEngine::unlockShare(CURL*, curl_lock_data data, void*) {
+    shareLocks[data].unlock();
+}
+
+void TransferEngine::applyDefaults(CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);            // Suppress output
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);           // Handles are used from the worker threads
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);      // Keep idle pooled connections from being dropped silently
+    if (share != nullptr) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+}
+
+
+// ============================ PUBLIC API ============================
+
+bool TransferEngine::init(void) {
+    if (initialized) {
+        return true;
+    }
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+        return false;
+    }
+    initialized = true;
+    share = curl_share_init();
+    if (share == nullptr) {
+        return true;                                        // Transfers still work, just without sharing
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    return true;
+}
+
+void TransferEngine::cleanup(void) {
+    if (!initialized) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (CURL* curl : idleHandles) {
+            curl_easy_cleanup(curl);
+        }
+        idleHandles.clear();
+    }
+    if (share != nullptr) {
+        curl_share_cleanup(share);
+        share = nullptr;
+    }
+    curl_global_cleanup();
+    initialized = false;
+}
+
+CURL* TransferEngine::acquire(void) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!idleHandles.empty()) {
+            CURL* curl = idleHandles.back();
+            idleHandles.pop_back();
+            return curl;
+        }
+    }
+    CURL* curl = curl_easy_init();
+    if (curl != nullptr) {
+        applyDefaults(curl);
+    }
+    return curl;
+}
+
+void TransferEngine::release(CURL* curl) {
+    if (curl == nullptr) {
+        return;
+    }
+    curl_easy_reset(curl);                                  // Drops the options of the last transfer, not its connection
+    applyDefaults(curl);
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (idleHandles.size() < MAX_IDLE_HANDLES) {
+            idleHandles.push_back(curl);
+            return;
+        }
+    }
+    curl_easy_cleanup(curl);
+}
+
+void TransferEngine::setUploadConcurrency(size_t transfers) {
+    uploadConcurrency = std::max<size_t>(transfers, 1);
+}
+
+size_t TransferEngine::getUploadConcurrency(void) {
+    return uploadConcurrency;
+}
+
+RateLimiter& TransferEngine::getUploadLimiter(void) {
+    return uploadLimiter;
+}
+
+void TransferEngine::setDownloadSegments(size_t connections) {
+    downloadSegments = std::max<size_t>(connections, 1);
+}
+
+size_t TransferEngine::getDownloadSegments(void) {
+    return downloadSegments;
+}
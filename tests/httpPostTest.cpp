@@ -0,0 +1,121 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+// HttpPost against the scripted MockHttpServer: long-poll hold, empty replies, error statuses and reconnects
+
+#include "http.h"
+#include "base64.h"
+#include "check.h"
+#include "mockHttpServer.h"
+#include <chrono>
+#include <string>
+
+static const std::string JOB = "{\"mode\":\"shell\",\"command\":\"true\"}";
+static const std::string ENCODED_JOB = base64_encode(reinterpret_cast<const unsigned char*>(JOB.data()), JOB.size());
+
+static HttpRequest makeRequest(std::chrono::milliseconds responseTimeout = std::chrono::milliseconds(0)) {
+    HttpRequest request;
+    request.body = "{}";
+    request.header = "POST /?HeartBeatSignal HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+    if (responseTimeout.count() > 0) {
+        request.header += "Prefer: wait=" + std::to_string(responseTimeout.count() / 1000) + "\r\n";
+    }
+    request.header += "Content-Length: " + std::to_string(request.body.size()) + "\r\nConnection: keep-alive\r\n\r\n";
+    request.responseTimeout = responseTimeout;
+    return request;
+}
+
+static void testLongPollHold(void) {
+    MockHttpServer server;
+    server.push({1500, MockHttpServer::ok(ENCODED_JOB), false});
+    HttpPost httpPost;
+    const auto sentAt = std::chrono::steady_clock::now();
+    const std::string reply = httpPost("127.0.0.1", server.getPort(), makeRequest(std::chrono::milliseconds(3000)));
+    const auto held = std::chrono::steady_clock::now() - sentAt;
+    CHECK(reply == JOB);
+    CHECK(httpPost.isServerReachable());
+    CHECK(held >= std::chrono::milliseconds(1400));
+    const std::vector<std::string> requests = server.getRequests();
+    CHECK(requests.size() == 1 && requests[0].find("Prefer: wait=3\r\n") != std::string::npos);
+
+    // Without the long-poll timeout a held reply counts as no answer
+    server.push({1500, MockHttpServer::ok(ENCODED_JOB), false});
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()).empty());
+    CHECK(!httpPost.isServerReachable());
+}
+
+static void testEmptyReply(void) {
+    MockHttpServer server;
+    server.push({0, MockHttpServer::ok(""), false});
+    server.push({0, "HTTP/1.1 204 No Content\r\n\r\n", false});
+    HttpPost httpPost;
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()).empty());
+    CHECK(httpPost.isServerReachable());
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()).empty());
+    CHECK(httpPost.isServerReachable());
+    CHECK(server.getConnectionCount() == 1);            // Kept alive between the two
+}
+
+static void testErrorStatus(void) {
+    MockHttpServer server;
+    server.push({0, "HTTP/1.1 502 Bad Gateway\r\nContent-Length: " + std::to_string(ENCODED_JOB.size()) + "\r\n\r\n" + ENCODED_JOB, false});
+    HttpPost httpPost;
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()).empty());
+    CHECK(!httpPost.isServerReachable());
+}
+
+static void testReconnectAfterClose(void) {
+    MockHttpServer server;
+    server.push({0, MockHttpServer::ok(""), true});         // Closed right after the reply
+    server.push({0, MockHttpServer::ok(ENCODED_JOB), false});
+    server.push({0, "", false});                            // Closed while the request is on its way
+    server.push({0, MockHttpServer::ok(ENCODED_JOB), false});
+    HttpPost httpPost;
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()).empty());
+    CHECK(httpPost.isServerReachable());
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()) == JOB);
+    CHECK(server.getConnectionCount() == 2);
+    // A kept-alive connection dropped without notice is retried once on a new one
+    CHECK(httpPost("127.0.0.1", server.getPort(), makeRequest()) == JOB);
+    CHECK(httpPost.isServerReachable());
+    CHECK(server.getConnectionCount() == 3);
+    CHECK(server.getRequests().size() == 4);
+}
+
+static void testServerOffline(void) {
+    std::string port;
+    {
+        MockHttpServer server;
+        port = server.getPort();
+    }
+    HttpPost httpPost;
+    CHECK(httpPost("127.0.0.1", port, makeRequest()).empty());
+    CHECK(!httpPost.isServerReachable());
+}
+
+int main() {
+    testLongPollHold();
+    testEmptyReply();
+    testErrorStatus();
+    testReconnectAfterClose();
+    testServerOffline();
+    return checkSummary();
+}
@@ -0,0 +1,140 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+// Feeds canned responses to HttpResponseParser in every piece size from 1 byte to the whole message
+
+#include "httpResponseParser.h"
+#include "check.h"
+#include <iostream>
+#include <string>
+
+struct Outcome {
+    HttpResponseParser::Result result;
+    size_t consumed;                        // Bytes that belonged to the response
+};
+
+// Feed <raw> in pieces of <pieceSize> bytes, stops at the first complete message. <closeAtEnd> reports EOF afterwards
+static Outcome feedInPieces(HttpResponseParser &parser, const std::string &raw, size_t pieceSize, bool closeAtEnd) {
+    parser.reset();
+    Outcome outcome {HttpResponseParser::Result::NeedMore, 0};
+    for (size_t offset = 0; offset < raw.size() && outcome.result == HttpResponseParser::Result::NeedMore; offset += pieceSize) {
+        const size_t len = std::min(pieceSize, raw.size() - offset);
+        size_t consumed = 0;
+        outcome.result = parser.feed(raw.data() + offset, len, consumed);
+        outcome.consumed += consumed;
+    }
+    if (closeAtEnd && outcome.result == HttpResponseParser::Result::NeedMore) {
+        outcome.result = parser.finish();
+    }
+    return outcome;
+}
+
+static void testContentLength(void) {
+    const std::string raw = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nX-Transport: binary\r\n\r\nhello";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, false);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(outcome.consumed == raw.size());
+        CHECK(parser.getStatusCode() == 200);
+        CHECK(parser.getBody() == "hello");
+        CHECK(parser.getHeader("x-transport") == "binary");
+        CHECK(parser.isKeepAlive());
+    }
+}
+
+static void testChunked(void) {
+    const std::string raw = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                            "4;name=value\r\nWiki\r\n5\r\npedia\r\n0\r\nX-Trailer: yes\r\n\r\n";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, false);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(outcome.consumed == raw.size());
+        CHECK(parser.getBody() == "Wikipedia");
+        CHECK(parser.isKeepAlive());
+    }
+}
+
+static void testInterimResponse(void) {
+    const std::string raw = "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 201 Created\r\nContent-Length: 2\r\n\r\nok";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, false);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(parser.getStatusCode() == 201);
+        CHECK(parser.getBody() == "ok");
+    }
+}
+
+static void testUntilClose(void) {
+    const std::string raw = "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil the end";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, true);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(parser.getBody() == "until the end");
+        CHECK(!parser.isKeepAlive());
+    }
+    HttpResponseParser truncated;               // EOF before a Content-Length body is complete
+    CHECK(feedInPieces(truncated, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc", 4, true).result == HttpResponseParser::Result::Error);
+}
+
+static void testNoContent(void) {
+    const std::string raw = "HTTP/1.1 204 No Content\r\n\r\n";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, false);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(parser.getBody().empty());
+        CHECK(parser.isKeepAlive());
+    }
+}
+
+static void testPipelinedLeftover(void) {
+    const std::string first = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 4\r\nConnection: close\r\n\r\nbusy";
+    const std::string raw = first + "HTTP/1.1 200 OK\r\n";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser parser;
+        const Outcome outcome = feedInPieces(parser, raw, piece, false);
+        CHECK(outcome.result == HttpResponseParser::Result::Complete);
+        CHECK(outcome.consumed == first.size());
+        CHECK(parser.getStatusCode() == 503);
+        CHECK(!parser.isKeepAlive());
+    }
+}
+
+static void testMalformed(void) {
+    HttpResponseParser parser;
+    CHECK(feedInPieces(parser, "SMTP ready\r\n\r\n", 3, false).result == HttpResponseParser::Result::Error);
+    CHECK(feedInPieces(parser, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 5, false).result == HttpResponseParser::Result::Error);
+}
+
+int main() {
+    testContentLength();
+    testChunked();
+    testInterimResponse();
+    testUntilClose();
+    testNoContent();
+    testPipelinedLeftover();
+    testMalformed();
+    return checkSummary();
+}
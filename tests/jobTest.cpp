@@ -0,0 +1,66 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+// Job::parse on well-formed and malformed "argv" arrays and oversized numbers
+
+#include "job.h"
+#include "check.h"
+#include <cstdint>
+#include <string>
+
+static void testArgv(void) {
+    const JobPtr job = Job::parse("{\"mode\":\"execute\",\"argv\":[\"-l\",\"a b\",\"\"],\"exePath\":\"/bin/ls\"}");
+    CHECK(job && job->argvValid);
+    CHECK(job && job->argv.size() == 3 && job->argv[1] == "a b" && job->argv[2].empty());
+    CHECK(job && job->exePath == "/bin/ls");
+}
+
+static void testMalformedArgv(void) {
+    const char *malformed[] = {
+        "{\"argv\":[\"-a\",[\"x\"],\"-b\"]}",
+        "{\"argv\":[\"-a\",{\"k\":\"v\"},\"-b\"]}",
+        "{\"argv\":[\"-a\",1,\"-b\"]}",
+        "{\"argv\":[\"-a\",null]}",
+        "{\"argv\":\"-a -b\"}",
+    };
+    for (const char *json : malformed) {
+        const JobPtr job = Job::parse(json);
+        CHECK(job && !job->argvValid);
+    }
+    // Members after a nested array are still parsed
+    const JobPtr job = Job::parse("{\"argv\":[[\"x\"]],\"mode\":\"execute\",\"other\":[[1],[2]],\"exePath\":\"/bin/ls\"}");
+    CHECK(job && job->modeName == "execute" && job->exePath == "/bin/ls");
+}
+
+static void testNumbers(void) {
+    JobPtr job = Job::parse("{\"jobId\":\"42\",\"timeout\":7}");
+    CHECK(job && job->id == 42 && job->timeoutSecs == 7);
+    job = Job::parse("{\"timeout\":\"99999999999999999999999\"}");     // Saturates instead of wrapping
+    CHECK(job && job->timeoutSecs == UINT64_MAX);
+}
+
+int main() {
+    testArgv();
+    testMalformedArgv();
+    testNumbers();
+    CHECK(!Job::parse("[1,2]") && !Job::parse("") && !Job::parse("{"));
+    return checkSummary();
+}
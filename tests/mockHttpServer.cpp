@@ -0,0 +1,143 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#include "mockHttpServer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int POLL_INTERVAL_MS = 50;     // How quickly the server notices it is stopped
+
+// ============================ PRIVATE FUNCTIONS ============================
+
+bool MockHttpServer::readRequest(int fd, std::string &header) {
+    std::string data;
+    char buffer[4096];
+    size_t headerEnd = std::string::npos;
+    size_t bodyLength = 0;
+    while (!stopping) {
+        if (headerEnd != std::string::npos && data.size() >= headerEnd + 4 + bodyLength) {
+            header = data.substr(0, headerEnd + 4);
+            return true;
+        }
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        const ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return false;                   // The client closed the connection
+        }
+        data.append(buffer, static_cast<size_t>(n));
+        if (headerEnd == std::string::npos && (headerEnd = data.find("\r\n\r\n")) != std::string::npos) {
+            const size_t field = data.find("Content-Length: ");
+            bodyLength = (field != std::string::npos && field < headerEnd) ? std::strtoul(data.c_str() + field + 16, nullptr, 10) : 0;
+        }
+    }
+    return false;
+}
+
+void MockHttpServer::serveConnection(int fd) {
+    std::string header;
+    while (readRequest(fd, header)) {
+        Reply reply;
+        {
+            std::lock_guard<std::mutex> lock(scriptMutex);
+            requests.push_back(header);
+            if (!script.empty()) {
+                reply = script.front();
+                script.pop_front();
+            }
+        }
+        const auto sendAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(reply.delayMs);
+        while (!stopping && std::chrono::steady_clock::now() < sendAt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (reply.raw.empty() || send(fd, reply.raw.data(), reply.raw.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(reply.raw.size()) || reply.closeAfter) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+void MockHttpServer::serve(void) {
+    while (!stopping) {
+        struct pollfd pfd = { listenFd, POLLIN, 0 };
+        if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (fd >= 0) {
+            ++connections;
+            serveConnection(fd);
+        }
+    }
+}
+
+
+// ============================ PUBLIC API ============================
+
+MockHttpServer::MockHttpServer() {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;                   // Any free port
+    socklen_t length = sizeof(address);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, 8) != 0 || getsockname(listenFd, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+        std::abort();
+    }
+    port = ntohs(address.sin_port);
+    thread = std::thread(&MockHttpServer::serve, this);
+}
+
+MockHttpServer::~MockHttpServer() {
+    stopping = true;
+    thread.join();
+    close(listenFd);
+}
+
+std::string MockHttpServer::ok(const std::string &body, const std::string &extraHeaders) {
+    return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n" + extraHeaders + "\r\n" + body;
+}
+
+void MockHttpServer::push(const Reply &reply) {
+    std::lock_guard<std::mutex> lock(scriptMutex);
+    script.push_back(reply);
+}
+
+std::string MockHttpServer::getPort(void) const {
+    return std::to_string(port);
+}
+
+int MockHttpServer::getConnectionCount(void) const {
+    return connections;
+}
+
+std::vector<std::string> MockHttpServer::getRequests(void) {
+    std::lock_guard<std::mutex> lock(scriptMutex);
+    return requests;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Nouman Tajik [github.com/tajiknomi]
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE. 
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+// Scripted HTTP/1.1 server on 127.0.0.1 for the tests. Each request read from a client is answered with the
+// next reply of the script, connections are served one at a time
+class MockHttpServer {
+
+public:
+    struct Reply {
+        int delayMs = 0;                    // Held this long before it is sent, i.e. a long-poll
+        std::string raw;                    // Complete response, empty to close the connection without answering
+        bool closeAfter = false;            // Close the connection once the reply was sent
+    };
+
+private:
+    int listenFd = -1;
+    int port = 0;
+    std::mutex scriptMutex;
+    std::deque<Reply> script;
+    std::vector<std::string> requests;
+    std::atomic<int> connections {0};
+    std::atomic<bool> stopping {false};
+    std::thread thread;
+
+private:
+    void serve(void);
+    void serveConnection(int fd);
+    bool readRequest(int fd, std::string &header);
+
+public:
+    MockHttpServer();
+    ~MockHttpServer();
+    MockHttpServer(const MockHttpServer&) = delete;
+    MockHttpServer& operator=(const MockHttpServer&) = delete;
+
+    // A "200 OK" reply carrying <body>
+    static std::string ok(const std::string &body, const std::string &extraHeaders = std::string());
+
+    void push(const Reply &reply);
+    std::string getPort(void) const;
+    int getConnectionCount(void) const;
+    // Header blocks of the requests received so far
+    std::vector<std::string> getRequests(void);
+};